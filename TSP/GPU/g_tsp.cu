@@ -13,7 +13,16 @@
 #include <limits.h>
 #include <time.h>
 
+/* Instance files are read by the same loader as the CPU solvers.
+   Build: nvcc g_tsp.cu ../tsp_file.c */
+extern "C" {
+#include "../tsp_file.h"
+}
+
 #define N 1000
+/* Largest tour whose ranks fit in 64 bits (20!), plus the fixed city of
+   canonical mode. */
+#define MAX_CITIES 21
 
 /* Reference an element in the TSP distance array. */
 #define TSP_ELT(tsp, n, i, j) *(tsp + (i * n) + j)
@@ -28,12 +37,6 @@ typedef void (*perm_action_t)(int *v, int n);
 /////////////////////////////////////////////////////////////////////
 
 
-typedef struct {
-    int *values;  /* Values stored in list */
-    int max_size; /* Maximum size allocated */
-    int cur_size; /* Size currently in use */
-} list_t;
-
 /* Swap v[i] and v[j] */
 __device__ void swap(int *v, int i, int j) {
     int t = v[i];
@@ -41,83 +44,6 @@ __device__ void swap(int *v, int i, int j) {
     v[j] = t;
 }
 
-/* Dump list, including sizes */
-__device__ void list_dump(list_t *list) {
-    //printf("%2d/%2d", list->cur_size, list->max_size);
-    for (int i = 0; i < list->cur_size; i++) {
-        printf(" %d", list->values[i]);
-    }
-    printf("\n");
-}
-
-/* Allocate list that can store up to 'max_size' elements */
-__device__ list_t *
-list_alloc(int max_size) {
-    list_t *list = (list_t *)malloc(sizeof(list_t));
-    list->values = (int *)malloc(max_size * sizeof(int));
-    list->max_size = max_size;
-    list->cur_size = 0;
-    return list;
-}
-
-/* Free a list; call this to avoid leaking memory! */
-__device__ void list_free(list_t *list) {
-    free(list->values);
-    free(list);
-}
-
-/* Add a value to the end of the list */
-__device__ void list_add(list_t *list, int value) {
-    if (list->cur_size >= list->max_size) {
-        printf("List full");
-        list_dump(list);
-        //exit(1);
-    }
-    list->values[list->cur_size++] = value;
-}
-
-/* Return the current size of the list */
-__device__ int list_size(list_t *list) {
-    return list->cur_size;
-}
-
-/* Validate index */
-__device__ void _list_check_index(list_t *list, int index) {
-    if (index < 0 || index > list->cur_size - 1) {
-        printf("Invalid index %d\n", index);
-        list_dump(list);
-        //exit(1);
-    }
-}
-
-/* Get the value at given index */
-__device__ int list_get(list_t *list, int index) {
-    _list_check_index(list, index);
-    return list->values[index];
-}
-
-/* Remove the value at the given index */
-__device__ void list_remove_at(list_t *list, int index) {
-    _list_check_index(list, index);
-    for (int i = index; i < list->cur_size - 1; i++) {
-        list->values[i] = list->values[i + 1];
-    }
-    list->cur_size--;
-}
-
-/* Retrieve a copy of the values as a simple array of integers. The returned
-   array is allocated dynamically; the caller must free the space when no
-   longer needed.
- */
-__device__ int *list_as_array(list_t *list) {
-    int *rtn = (int *)malloc(list->max_size * sizeof(int));
-    for (int i = 0; i < list->max_size; i++) {
-        rtn[i] = list_get(list, i);
-    }
-    return rtn;
-}
- 
-
 /* Calculate n! iteratively */
 __device__ long factorial(int n) {
     if (n < 1) {
@@ -143,41 +69,39 @@ long host_factorial(int n) {
     return rtn;
 }
 
-/* Return the kth lexographically ordered permuation of an array of size integers
-   in the range [0 .. size - 1]. The integers are allocated dynamically and
-   should be free'd by the caller when no longer needed.
-*/
-__device__ int *kth_perm(int k, int size) {
-    long remain = k - 1;
-    list_t *numbers = list_alloc(size);
-    for (int i = 0; i < size; i++) {
-        list_add(numbers, i);
-    }
-
-    list_t *perm = list_alloc(size);
-
-    for (int i = 1; i < size; i++) {
-        long f = factorial(size - i);
-        long j = remain / f;
-        remain = remain % f;
-
-        list_add(perm, list_get(numbers, j));
-        list_remove_at(numbers, j);
-
-        if (remain == 0) {
-            break;
+/* Position of the j-th (from 0) set bit of mask, by binary search on
+   popcounts: six steps whatever the width. */
+__device__ int select_bit(unsigned long long mask, int j) {
+    int pos = 0;
+    for (int width = 32; width > 0; width >>= 1) {
+        int below = __popcll(mask & ((1ULL << width) - 1));
+        if (j >= below) {
+            j -= below;
+            mask >>= width;
+            pos += width;
         }
     }
+    return pos;
+}
 
-    /* Append remaining digits */
-    for (int i = 0; i < list_size(numbers); i++) {
-        list_add(perm, list_get(numbers, i));
+/* Write the rank-th (from 0) lexographically ordered permutation of
+   [0 .. size - 1] into perm. The unused values are a bitmask, so nothing is
+   allocated and each digit costs a select instead of a list shift.
+   Requires size <= MAX_CITIES.
+*/
+__device__ void perm_unrank(unsigned long long rank, int size, int *perm) {
+    unsigned long long unused = (1ULL << size) - 1;
+    for (int i = 0; i < size; i++) {
+        unsigned long long f = factorial(size - 1 - i);
+        if (f == 0) {
+            f = 1;
+        }
+        int digit = (int)(rank / f);
+        rank %= f;
+        int value = select_bit(unused, digit);
+        perm[i] = value;
+        unused &= ~(1ULL << value);
     }
-
-    int *rtn = list_as_array(perm);
-    list_free(perm);
-
-    return rtn;
 }
 
 
@@ -185,8 +109,10 @@ __device__ int *kth_perm(int k, int size) {
    contain the lexographically next permutation. It is originally due to
    Dijkstra. The present version is discussed at:
    http://www.cut-the-knot.org/do_you_know/AllPerm.shtml
+   Returns the pivot: the lowest index whose value changed. Everything before
+   it is untouched, which lets tour costs be updated incrementally.
  */
-__device__ void next_perm(int *perm, int size) {
+__device__ int next_perm(int *perm, int size) {
     int i = size - 1;
     while (perm[i - 1] >= perm[i]) {
         i = i - 1;
@@ -198,6 +124,7 @@ __device__ void next_perm(int *perm, int size) {
     }
 
     swap(perm, i - 1, j - 1);
+    int pivot = i - 1;
 
     i++;
     j = size;
@@ -206,6 +133,7 @@ __device__ void next_perm(int *perm, int size) {
         i++;
         j--;
     }
+    return pivot;
 }
 
 
@@ -213,8 +141,9 @@ __device__ void next_perm(int *perm, int size) {
 // TSP all the way down...
 /////////////////////////////////////////////////////////////////////
 
-/* Create an instance of a symmetric TSP. */
-int *create_tsp(int n, int seed) {
+/* Create an instance of a symmetric TSP. C linkage, as tsp.h declares it:
+   tsp_random() in tsp_file.c calls it. */
+extern "C" int *create_tsp(int n, int seed) {
     int *tsp = (int *)malloc(n * n * sizeof(int));
 
     srandom(seed);
@@ -242,6 +171,39 @@ __device__ int eval_tsp(int *perm, int n, int *distances) {
     return total;
 }
 
+/* Incremental version of eval_tsp(). prefix[k] holds the length of the path
+   perm[0] .. perm[k]; entries below 'from' (the pivot from next_perm()) are
+   still valid, so only the changed suffix is re-summed.
+ */
+__device__ int eval_tsp_from(int *perm, int n, int *distances, int *prefix, int from) {
+    if (from < 1) {
+        prefix[0] = 0;
+        from = 1;
+    }
+    for (int k = from; k < n; k++) {
+        prefix[k] = prefix[k - 1] + TSP_ELT(distances, n, perm[k - 1], perm[k]);
+    }
+    return prefix[n - 1] + TSP_ELT(distances, n, perm[n - 1], perm[0]);
+}
+
+/* Canonical tours start at city 0 and visit city 1 before city 2, which
+   picks one of the two directions around each cycle. Tells whether perm is
+   canonical, given that nothing before 'pivot' changed since the last call.
+   *first caches the position of whichever of cities 1 and 2 comes first.
+ */
+__device__ int is_canonical(int *perm, int n, int pivot, int *first) {
+    if (pivot <= *first) {
+        *first = n;
+        for (int k = pivot; k < n; k++) {
+            if (perm[k] == 1 || perm[k] == 2) {
+                *first = k;
+                break;
+            }
+        }
+    }
+    return *first == n || perm[*first] == 1;
+}
+
 /* Print a TSP distance matrix. */
 void print_tsp(int *tsp, int n, int random_seed) {
     printf("TSP (%d cities - seed %d)\n    ", n, random_seed);
@@ -266,23 +228,50 @@ void print_tsp(int *tsp, int n, int random_seed) {
 /**
  * 
  */
-__global__ void compute_shortest_path(int num_cities, int num_threads, int *dists, int *mins) {
+__global__ void compute_shortest_path(int num_cities, int num_threads, int canonical, int *dists, int *mins, long *counts) {
     int shortest_length = INT_MAX;
+    //tours this thread scored; in canonical mode about half its ranks
+    long checked = 0;
     int tid = threadIdx.x;
-    long max_check = factorial(num_cities);
+    //in canonical mode city 0 stays in front and only the rest are ranked
+    int fixed = canonical ? 1 : 0;
+    int ranked_cities = num_cities - fixed;
+    long max_check = factorial(ranked_cities);
     long tours_to_check = max_check / num_threads;
-    int *current = kth_perm((tid+1)*tours_to_check, num_cities);
-    int at = tid*tours_to_check;
+    long start = tid*tours_to_check;
+    //last thread also takes the leftover tours
+    long end = (tid == num_threads - 1) ? max_check : start + tours_to_check;
+    int ranked[MAX_CITIES];
+    int current[MAX_CITIES];
+    int prefix[MAX_CITIES];
+    perm_unrank(start, ranked_cities, ranked);
+    current[0] = 0;
+    for(int i = 0; i < ranked_cities; i++) {
+        current[i + fixed] = ranked[i] + fixed;
+    }
+    int pivot = 0;
+    int dirty = 0;
+    int first = 0;
+    long at = start;
     do {
-        int temp = eval_tsp(current, num_cities, dists);
-        if(temp < shortest_length) {
-            shortest_length = temp;
+        if(!canonical || is_canonical(current, num_cities, pivot, &first)) {
+            int temp = eval_tsp_from(current, num_cities, dists, prefix, dirty);
+            dirty = num_cities;
+            checked++;
+            if(temp < shortest_length) {
+                shortest_length = temp;
+            }
         }
-        next_perm(current, num_cities);
         at++;
-    } while (at < (int)((tid+1)*tours_to_check)-1);
+        if(at < end) {
+            pivot = fixed + next_perm(current + fixed, ranked_cities);
+            if(pivot < dirty) {
+                dirty = pivot;
+            }
+        }
+    } while (at < end);
     *(mins + (tid)) = shortest_length;
-    free(current); 
+    *(counts + (tid)) = checked;
 }
 
 //get current time
@@ -297,7 +286,9 @@ void usage(char *prog_name) {
     fprintf(stderr, "   -h\n");
     fprintf(stderr, "   -c <number of cities>\n");
     fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
     fprintf(stderr, "   -n <number of threads>\n");
+    fprintf(stderr, "   -u (unique tours only: fix city 0, skip reflections)\n");
     exit(1);
 }
 
@@ -305,24 +296,58 @@ int main(int argc, char **argv) {
     int random_seed = 42;
     int num_cities = 5;
     int num_threads = 1;
+    int canonical = 0;
+    char *tsp_file_name = NULL;
     int ch;
-    while ((ch = getopt(argc, argv, "c:hs:n:")) != -1) {
+    while ((ch = getopt(argc, argv, "c:f:hs:n:u")) != -1) {
         switch (ch) {
         case 'c':
             num_cities = atoi(optarg);
             break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
         case 's':
             random_seed = atoi(optarg);
             break;
         case 'n':
             num_threads = atoi(optarg);
             break;
+        case 'u':
+            canonical = 1;
+            break;
         case 'h':
         default:
             usage(argv[0]);
         }
     }
-    long fact = host_factorial(num_cities);
+    //create host distances, from the file if given
+    int *h_distances;
+    if(tsp_file_name != NULL) {
+        h_distances = load_tsp(tsp_file_name, &num_cities);
+    }
+    else {
+        h_distances = create_tsp(num_cities, random_seed);
+    }
+
+    //canonical tours need cities 1 and 2 to tell the directions apart
+    if(num_cities < 3) {
+        canonical = 0;
+    }
+    //and skipping reflections only works if both directions cost the same
+    for(int i = 0; canonical && i < num_cities; i++) {
+        for(int j = 0; j < i; j++) {
+            if(TSP_ELT(h_distances, num_cities, i, j) != TSP_ELT(h_distances, num_cities, j, i)) {
+                fprintf(stderr, "Canonical mode (-u) needs a symmetric instance\n");
+                exit(1);
+            }
+        }
+    }
+    if(num_cities < 1 || num_cities - canonical > MAX_CITIES - 1) {
+        fprintf(stderr, "Number of cities must be in [1 .. %d]\n", MAX_CITIES - 1 + canonical);
+        exit(1);
+    }
+    long fact = host_factorial(num_cities - canonical);
 
     //Checks to see if factorial is essentially less than 1024
     //or the number of specified threads. If so, this statement
@@ -333,36 +358,53 @@ int main(int argc, char **argv) {
         fprintf(stderr, "Too many processors to run effectively...\nRefactoring number of threads to be 1:1...\nNow running on %d GPU threads\n", num_threads);
     }
     
-    //create host distances and minimum arrays
-    int *h_distances = create_tsp(num_cities, random_seed);
+    //create host minimum and count arrays
     int *h_min_distances = (int *)malloc(num_threads * sizeof(int));
+    long *h_counts = (long *)malloc(num_threads * sizeof(long));
 
-    //create device distances and minimum arrays
+    //create device distances, minimum and count arrays
     int *d_distances; 
     int *d_min_distances;
+    long *d_counts;
     cudaMalloc((void **)&d_distances, num_cities * num_cities * sizeof(int));
     cudaMalloc((void **)&d_min_distances, num_threads * sizeof(int));
+    cudaMalloc((void **)&d_counts, num_threads * sizeof(long));
 
     cudaMemcpy(d_distances, h_distances, num_cities * num_cities * sizeof(int), cudaMemcpyHostToDevice);
     double start_time = now();
-    compute_shortest_path<<<1, num_threads>>>(num_cities, num_threads, d_distances, d_min_distances);
+    compute_shortest_path<<<1, num_threads>>>(num_cities, num_threads, canonical, d_distances, d_min_distances, d_counts);
 
     cudaMemcpy(h_min_distances, d_min_distances, num_threads * sizeof(int), cudaMemcpyDeviceToHost);
+    cudaMemcpy(h_counts, d_counts, num_threads * sizeof(long), cudaMemcpyDeviceToHost);
 
     cudaFree(d_distances);
     cudaFree(d_min_distances);
+    cudaFree(d_counts);
     
     int lowest = INT_MAX;
+    long checked = 0;
     for(int i = 0; i < num_threads; i++) {
         int val = *((h_min_distances) + i);
         if(val < lowest) {
             lowest = val;
         }
+        checked += *((h_counts) + i);
     }
     free(h_min_distances);
+    free(h_counts);
     free(h_distances);
 
-    printf("Lowest tour %d found on seed %d in %5.3f seconds\n", lowest, random_seed, now() - start_time);
+    double elapsed = now() - start_time;
+    printf("Lowest tour %d found on seed %d in %5.3f seconds\n", lowest, random_seed, elapsed);
+    //count the tours scored, as the CPU engines do; in canonical mode each
+    //stands for its n rotations both ways (tour_multiplicity() in tsp.c)
+    if(canonical) {
+        printf("Checked %ld tours (canonical; each covers %d tours) on %d GPU threads (%.0f tours/second)\n",
+               checked, 2 * num_cities, num_threads, checked / elapsed);
+    }
+    else {
+        printf("Checked %ld tours on %d GPU threads (%.0f tours/second)\n", checked, num_threads, checked / elapsed);
+    }
     
     return 0;
 }
@@ -0,0 +1,175 @@
+/**
+ * Batched tour evaluation.
+ *
+ * Scoring one tour at a time is a chain of dependent scalar loads from the
+ * distance matrix. Holding a block of tours structure-of-arrays lets one
+ * vector gather fetch the same edge of 8 (AVX2) or 16 (AVX-512) tours at
+ * once. The widest version the CPU supports is picked at run time; the
+ * scalar one is always there as a fallback.
+ *
+ * Distances are read at the width of the instance (see tsp_file.c). There
+ * is no gather of bytes or 16-bit words, so for those each lane loads the
+ * 4 bytes that end at its distance and shifts the rest out; the bytes in
+ * front of the matrix that the first distance needs are TSP_DATA_LEAD.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tsp_file.h"
+#include "batch_eval.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+const char *batch_eval_name = "scalar";
+
+/* Portable version: one tour at a time, for each width. */
+#define DEFINE_BATCH_SCALAR(name, type)                                       \
+    static void eval_batch_scalar_##name(const int *soa, int n, int count,   \
+                                         const type *tsp, int *lengths) {    \
+        for (int t = 0; t < count; t++) {                                    \
+            int first = soa[t];                                              \
+            int prev = first;                                                \
+            int total = 0;                                                   \
+            for (int p = 1; p < n; p++) {                                    \
+                int cur = soa[p * BATCH_SIZE + t];                           \
+                total += tsp[prev * n + cur];                                \
+                prev = cur;                                                  \
+            }                                                                \
+            lengths[t] = total + tsp[prev * n + first];                      \
+        }                                                                    \
+    }
+
+DEFINE_BATCH_SCALAR(u8, unsigned char)
+DEFINE_BATCH_SCALAR(u16, unsigned short)
+DEFINE_BATCH_SCALAR(i32, int)
+
+static void eval_batch_scalar(const int *soa, int n, int count, const tsp_file_t *tsp, int *lengths) {
+    if (tsp->elt_size == 1) {
+        eval_batch_scalar_u8(soa, n, count, tsp->data, lengths);
+    }
+    else if (tsp->elt_size == 2) {
+        eval_batch_scalar_u16(soa, n, count, tsp->data, lengths);
+    }
+    else {
+        eval_batch_scalar_i32(soa, n, count, tsp->data, lengths);
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+/* Gather the distances at element indexes idx of a matrix of SIZE byte
+   distances: load the 4 bytes ending at each and keep the top SIZE. */
+#define GATHER_AVX2(base, idx, SIZE)                                          \
+    _mm256_srli_epi32(_mm256_i32gather_epi32((const int *)(base), idx, SIZE), 32 - 8 * (SIZE))
+#define GATHER_AVX512(base, idx, SIZE)                                        \
+    _mm512_srli_epi32(_mm512_i32gather_epi32(idx, (const void *)(base), SIZE), 32 - 8 * (SIZE))
+
+#define DEFINE_BATCH_AVX2(name, SIZE)                                         \
+    __attribute__((target("avx2")))                                          \
+    static void eval_batch_avx2_##name(const int *soa, int n, int count,     \
+                                       const tsp_file_t *tsp, int *lengths) { \
+        const char *base = (const char *)tsp->data - (4 - (SIZE));           \
+        const __m256i width = _mm256_set1_epi32(n);                          \
+        int t = 0;                                                           \
+        for (; t + 8 <= count; t += 8) {                                     \
+            __m256i first = _mm256_loadu_si256((const __m256i *)(soa + t));  \
+            __m256i prev = first;                                            \
+            __m256i total = _mm256_setzero_si256();                          \
+            for (int p = 1; p < n; p++) {                                    \
+                __m256i cur = _mm256_loadu_si256((const __m256i *)(soa + p * BATCH_SIZE + t)); \
+                __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(prev, width), cur); \
+                total = _mm256_add_epi32(total, GATHER_AVX2(base, idx, SIZE)); \
+                prev = cur;                                                  \
+            }                                                                \
+            __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(prev, width), first); \
+            total = _mm256_add_epi32(total, GATHER_AVX2(base, idx, SIZE));   \
+            _mm256_storeu_si256((__m256i *)(lengths + t), total);            \
+        }                                                                    \
+        if (t < count) {                                                     \
+            eval_batch_scalar(soa + t, n, count - t, tsp, lengths + t);      \
+        }                                                                    \
+    }
+
+#define DEFINE_BATCH_AVX512(name, SIZE)                                       \
+    __attribute__((target("avx512f")))                                       \
+    static void eval_batch_avx512_##name(const int *soa, int n, int count,   \
+                                         const tsp_file_t *tsp, int *lengths) { \
+        const char *base = (const char *)tsp->data - (4 - (SIZE));           \
+        const __m512i width = _mm512_set1_epi32(n);                          \
+        int t = 0;                                                           \
+        for (; t + 16 <= count; t += 16) {                                   \
+            __m512i first = _mm512_loadu_si512((const void *)(soa + t));     \
+            __m512i prev = first;                                            \
+            __m512i total = _mm512_setzero_si512();                          \
+            for (int p = 1; p < n; p++) {                                    \
+                __m512i cur = _mm512_loadu_si512((const void *)(soa + p * BATCH_SIZE + t)); \
+                __m512i idx = _mm512_add_epi32(_mm512_mullo_epi32(prev, width), cur); \
+                total = _mm512_add_epi32(total, GATHER_AVX512(base, idx, SIZE)); \
+                prev = cur;                                                  \
+            }                                                                \
+            __m512i idx = _mm512_add_epi32(_mm512_mullo_epi32(prev, width), first); \
+            total = _mm512_add_epi32(total, GATHER_AVX512(base, idx, SIZE)); \
+            _mm512_storeu_si512((void *)(lengths + t), total);               \
+        }                                                                    \
+        if (t < count) {                                                     \
+            eval_batch_scalar(soa + t, n, count - t, tsp, lengths + t);      \
+        }                                                                    \
+    }
+
+DEFINE_BATCH_AVX2(u8, 1)
+DEFINE_BATCH_AVX2(u16, 2)
+DEFINE_BATCH_AVX2(i32, 4)
+DEFINE_BATCH_AVX512(u8, 1)
+DEFINE_BATCH_AVX512(u16, 2)
+DEFINE_BATCH_AVX512(i32, 4)
+
+static void eval_batch_avx2(const int *soa, int n, int count, const tsp_file_t *tsp, int *lengths) {
+    if (tsp->elt_size == 1) {
+        eval_batch_avx2_u8(soa, n, count, tsp, lengths);
+    }
+    else if (tsp->elt_size == 2) {
+        eval_batch_avx2_u16(soa, n, count, tsp, lengths);
+    }
+    else {
+        eval_batch_avx2_i32(soa, n, count, tsp, lengths);
+    }
+}
+
+static void eval_batch_avx512(const int *soa, int n, int count, const tsp_file_t *tsp, int *lengths) {
+    if (tsp->elt_size == 1) {
+        eval_batch_avx512_u8(soa, n, count, tsp, lengths);
+    }
+    else if (tsp->elt_size == 2) {
+        eval_batch_avx512_u16(soa, n, count, tsp, lengths);
+    }
+    else {
+        eval_batch_avx512_i32(soa, n, count, tsp, lengths);
+    }
+}
+#endif
+
+/* Return the widest evaluator this CPU can run. Setting BATCH_EVAL to
+   "scalar" or "avx2" in the environment caps it, for cross checks. */
+batch_eval_t select_batch_eval(void) {
+    const char *cap = getenv("BATCH_EVAL");
+    if (cap != NULL && strcmp(cap, "scalar") == 0) {
+        batch_eval_name = "scalar";
+        return eval_batch_scalar;
+    }
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    int allow_512 = (cap == NULL || strcmp(cap, "avx2") != 0);
+    if (allow_512 && __builtin_cpu_supports("avx512f")) {
+        batch_eval_name = "avx512";
+        return eval_batch_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        batch_eval_name = "avx2";
+        return eval_batch_avx2;
+    }
+#endif
+    batch_eval_name = "scalar";
+    return eval_batch_scalar;
+}
@@ -0,0 +1,12 @@
+/* Batched tour evaluation; see batch_eval.c. Needs tsp_file.h first, for
+   tsp_file_t. */
+
+/* Tours per block. A multiple of every vector width used. */
+#define BATCH_SIZE 64
+
+/* Score 'count' tours of n cities held structure-of-arrays: city at
+   position p of tour t is soa[p * BATCH_SIZE + t]. */
+typedef void (*batch_eval_t)(const int *soa, int n, int count, const tsp_file_t *tsp, int *lengths);
+
+extern batch_eval_t select_batch_eval(void);
+extern const char *batch_eval_name;
@@ -0,0 +1,108 @@
+/**
+ * Checkpoints for long exhaustive TSP searches.
+ *
+ * A search that walks tours in lexicographic order is fully described by
+ * the rank it has reached plus its running statistics, so that is all a
+ * checkpoint holds: a 16 byte header (magic "TSPK", version, size of the
+ * record) and a fixed-width record. A checkpoint is written to a temporary
+ * file and renamed over the old one, so a job killed mid-write still
+ * leaves the previous checkpoint intact.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tsp_file.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC "TSPK"
+#define CHECKPOINT_VERSION 1
+
+/* On-disk layout; fixed-width fields only. */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t unused;
+    int32_t num_cities;
+    int32_t canonical;
+    uint64_t instance_hash;
+    uint64_t next_rank;
+    int32_t shortest_length;
+    int32_t num_as_short;
+    int64_t num_trials;
+    int32_t best_tour[CHECKPOINT_MAX_CITIES];
+} checkpoint_file_t;
+
+/* FNV-1a over the distances, so a checkpoint is only resumed against the
+   instance it was taken on. Each is hashed as 4 bytes, whatever width it
+   is stored in. */
+uint64_t hash_tsp(tsp_file_t *f) {
+    int n = f->n;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (long i = 0; i < (long)n * n; i++) {
+        uint32_t d = (uint32_t)tsp_dist(f, i / n, i % n);
+        for (int b = 0; b < 4; b++) {
+            h = (h ^ ((d >> (8 * b)) & 0xff)) * 0x100000001b3ULL;
+        }
+    }
+    return h ^ (uint64_t)n;
+}
+
+void write_checkpoint(char *file_name, checkpoint_t *cp) {
+    checkpoint_file_t f;
+    memset(&f, 0, sizeof(f));
+    memcpy(f.magic, CHECKPOINT_MAGIC, 4);
+    f.version = CHECKPOINT_VERSION;
+    f.record_size = sizeof(f);
+    f.num_cities = cp->num_cities;
+    f.canonical = cp->canonical;
+    f.instance_hash = cp->instance_hash;
+    f.next_rank = cp->next_rank;
+    f.shortest_length = cp->shortest_length;
+    f.num_as_short = cp->num_as_short;
+    f.num_trials = cp->num_trials;
+    for (int i = 0; i < cp->num_cities && i < CHECKPOINT_MAX_CITIES; i++) {
+        f.best_tour[i] = cp->best_tour[i];
+    }
+
+    char tmp_name[strlen(file_name) + 5];
+    sprintf(tmp_name, "%s.tmp", file_name);
+    FILE *fp = fopen(tmp_name, "wb");
+    if (fp == NULL) {
+        perror(tmp_name);
+        exit(1);
+    }
+    if (fwrite(&f, sizeof(f), 1, fp) != 1 || fclose(fp) != 0 ||
+        rename(tmp_name, file_name) != 0) {
+        fprintf(stderr, "%s: can't write checkpoint\n", file_name);
+        exit(1);
+    }
+}
+
+/* Returns 0 if there is no checkpoint to read. */
+int read_checkpoint(char *file_name, checkpoint_t *cp) {
+    FILE *fp = fopen(file_name, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    checkpoint_file_t f;
+    if (fread(&f, sizeof(f), 1, fp) != 1 || memcmp(f.magic, CHECKPOINT_MAGIC, 4) != 0 ||
+        f.version != CHECKPOINT_VERSION || f.record_size != sizeof(f) ||
+        f.num_cities < 1 || f.num_cities > CHECKPOINT_MAX_CITIES) {
+        fprintf(stderr, "%s: not a checkpoint file\n", file_name);
+        exit(1);
+    }
+    fclose(fp);
+
+    cp->num_cities = f.num_cities;
+    cp->canonical = f.canonical;
+    cp->instance_hash = f.instance_hash;
+    cp->next_rank = f.next_rank;
+    cp->shortest_length = f.shortest_length;
+    cp->num_as_short = f.num_as_short;
+    cp->num_trials = f.num_trials;
+    for (int i = 0; i < f.num_cities; i++) {
+        cp->best_tour[i] = f.best_tour[i];
+    }
+    return 1;
+}
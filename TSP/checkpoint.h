@@ -0,0 +1,21 @@
+/* Checkpoints of long exhaustive searches; see checkpoint.c. Needs
+   tsp_file.h first, for tsp_file_t. */
+#include <stdint.h>
+
+/* Longest tour a checkpoint holds. */
+#define CHECKPOINT_MAX_CITIES 32
+
+typedef struct {
+    int num_cities;
+    int canonical;
+    uint64_t instance_hash;  /* hash_tsp() of the distance matrix */
+    uint64_t next_rank;      /* First lexicographic rank not yet evaluated */
+    int shortest_length;
+    int num_as_short;
+    long num_trials;
+    int best_tour[CHECKPOINT_MAX_CITIES];
+} checkpoint_t;
+
+extern uint64_t hash_tsp(tsp_file_t *f);
+extern void write_checkpoint(char *file_name, checkpoint_t *cp);
+extern int read_checkpoint(char *file_name, checkpoint_t *cp);
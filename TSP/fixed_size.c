@@ -0,0 +1,286 @@
+/**
+ * Lexicographic tour walks specialized by city count.
+ *
+ * The inner loop of the exhaustive search is next_perm() followed by
+ * re-summing the tour after the pivot. lex_walk_generic() is that loop, as
+ * in tsp-threads.c, with n a run-time value.
+ *
+ * The specialized walks are one always-inlined body instantiated for each n
+ * in [FIXED_MIN .. FIXED_MAX] with n a constant. Every sixth lexicographic
+ * step changes something before the last three positions; the other five
+ * only reorder those three cities. So the body takes the six orders of the
+ * last three as one unrolled block: the path up to them is summed once and
+ * each order costs four distance lookups at offsets fixed at compile time,
+ * with no next_perm() call and no loop. Only then is next_perm() called, to
+ * move to the next prefix. Other sizes use the generic walk.
+ * select_lex_walk() picks the version, as select_batch_eval() does;
+ * LEX_WALK=generic in the environment forces the generic one.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "perm.h"
+#include "fixed_size.h"
+
+const char *lex_walk_name = "generic";
+
+/* next_perm() from perm.c, inlined so size can be a constant. */
+static inline __attribute__((always_inline)) int next_perm_inline(int *perm, const int size) {
+    int i = size - 1;
+    while (perm[i - 1] >= perm[i]) {
+        i--;
+    }
+    int j = size;
+    while (perm[j - 1] <= perm[i - 1]) {
+        j--;
+    }
+    int t = perm[i - 1];
+    perm[i - 1] = perm[j - 1];
+    perm[j - 1] = t;
+    int pivot = i - 1;
+
+    for (j = size - 1; i < j; i++, j--) {
+        t = perm[i];
+        perm[i] = perm[j];
+        perm[j] = t;
+    }
+    return pivot;
+}
+
+static inline __attribute__((always_inline))
+void walk(const int *tsp, const int n, int canonical, uint64_t first_rank,
+          long count, int *best, walk_t *w) {
+    const int fixed = canonical ? 1 : 0;
+    const int m = n - fixed;
+    int perm[MAX_PERM_SIZE + 1];
+    int prefix[MAX_PERM_SIZE + 1];
+    int ranked[MAX_PERM_SIZE + 1];
+    int shortest = INT_MAX;
+    long num_as_short = 0;
+    long num_trials = 0;
+    int first = 0;
+    int dirty = 1;
+
+    perm_unrank(first_rank, m, ranked);
+    perm[0] = 0;
+    for (int i = 0; i < m; i++) {
+        perm[i + fixed] = ranked[i] + fixed;
+    }
+    prefix[0] = 0;
+
+    for (long k = 0; k < count; k++) {
+        int pivot = 0;
+        if (k > 0) {
+            pivot = fixed + next_perm_inline(perm + fixed, m);
+            dirty = (pivot < dirty) ? pivot : dirty;
+            dirty = (dirty < 1) ? 1 : dirty;
+        }
+        if (canonical) {
+            /* is_canonical() from tsp.c: city 1 before city 2. */
+            if (pivot <= first) {
+                first = n;
+                for (int i = pivot; i < n; i++) {
+                    if (perm[i] == 1 || perm[i] == 2) {
+                        first = i;
+                        break;
+                    }
+                }
+            }
+            if (first != n && perm[first] != 1) {
+                continue;
+            }
+        }
+
+        for (int i = dirty; i < n; i++) {
+            prefix[i] = prefix[i - 1] + tsp[perm[i - 1] * n + perm[i]];
+        }
+        dirty = n;
+        int total = prefix[n - 1] + tsp[perm[n - 1] * n + perm[0]];
+        num_trials++;
+        if (total <= shortest) {
+            if (total < shortest) {
+                shortest = total;
+                num_as_short = 0;
+                memcpy(best, perm, n * sizeof(int));
+            }
+            num_as_short++;
+        }
+    }
+    w->shortest = shortest;
+    w->num_as_short = num_as_short;
+    w->num_trials = num_trials;
+}
+
+void lex_walk_generic(const int *tsp, int n, int canonical, uint64_t first,
+                      long count, int *best, walk_t *w) {
+    walk(tsp, n, canonical, first, count, best, w);
+}
+
+/* Position of the first city 1 or 2 in perm[from .. end - 1], or end. */
+static inline int first_one_or_two(const int *perm, int from, int end) {
+    for (int i = from; i < end; i++) {
+        if (perm[i] == 1 || perm[i] == 2) {
+            return i;
+        }
+    }
+    return end;
+}
+
+/* Fold one tour into the walk's statistics. */
+static inline __attribute__((always_inline))
+void count_tour(int total, const int *perm, const int n, int *best, walk_t *w) {
+    w->num_trials++;
+    if (total <= w->shortest) {
+        if (total < w->shortest) {
+            w->shortest = total;
+            w->num_as_short = 0;
+            memcpy(best, perm, n * sizeof(int));
+        }
+        w->num_as_short++;
+    }
+}
+
+/* The walk in blocks of six; n is a constant wherever this is inlined. */
+static inline __attribute__((always_inline))
+void walk_blocks(const int *tsp, const int n, int canonical, uint64_t first_rank,
+                 long count, int *best, walk_t *w) {
+    const int fixed = canonical ? 1 : 0;
+    const int m = n - fixed;
+    const int tail = n - 3;     /* First of the last three positions */
+    int perm[MAX_PERM_SIZE + 1];
+    int prefix[MAX_PERM_SIZE + 1];
+    int ranked[MAX_PERM_SIZE + 1];
+    int dirty = 1;
+    int first = 0;              /* first_one_or_two(perm, 0, tail) */
+
+    perm_unrank(first_rank, m, ranked);
+    perm[0] = 0;
+    for (int i = 0; i < m; i++) {
+        perm[i + fixed] = ranked[i] + fixed;
+    }
+    prefix[0] = 0;
+    w->shortest = INT_MAX;
+    w->num_as_short = 0;
+    w->num_trials = 0;
+
+    long k = 0;
+    uint64_t rank = first_rank;
+    while (k < count) {
+        if (k > 0) {
+            int pivot = fixed + next_perm_inline(perm + fixed, m);
+            dirty = (pivot < dirty) ? pivot : dirty;
+            dirty = (dirty < 1) ? 1 : dirty;
+            if (pivot <= first) {
+                first = first_one_or_two(perm, pivot, tail);
+            }
+        }
+        else {
+            first = first_one_or_two(perm, 0, tail);
+        }
+
+        /* Sum the path up to the last three cities. */
+        for (int i = dirty; i < tail; i++) {
+            prefix[i] = prefix[i - 1] + tsp[perm[i - 1] * n + perm[i]];
+        }
+        dirty = tail;
+        const int *row_q = tsp + perm[tail - 1] * n;
+        int base = prefix[tail - 1];
+        int home = perm[0];
+
+        if (rank % 6 == 0 && count - k >= 6) {
+            /* The last three are in ascending order: take all six orders. */
+            int a = perm[tail];
+            int b = perm[tail + 1];
+            int c = perm[tail + 2];
+            const int *ra = tsp + a * n;
+            const int *rb = tsp + b * n;
+            const int *rc = tsp + c * n;
+            int orders[6][3] = {
+                { a, b, c }, { a, c, b }, { b, a, c }, { b, c, a }, { c, a, b }, { c, b, a }
+            };
+            int lengths[6] = {
+                row_q[a] + ra[b] + rb[c] + rc[home],
+                row_q[a] + ra[c] + rc[b] + rb[home],
+                row_q[b] + rb[a] + ra[c] + rc[home],
+                row_q[b] + rb[c] + rc[a] + ra[home],
+                row_q[c] + rc[a] + ra[b] + rb[home],
+                row_q[c] + rc[b] + rb[a] + ra[home]
+            };
+            for (int o = 0; o < 6; o++) {
+                /* In canonical mode city 1 must come before city 2. */
+                if (canonical && first == tail) {
+                    int f = (orders[o][0] == 1 || orders[o][0] == 2) ? orders[o][0]
+                          : (orders[o][1] == 1 || orders[o][1] == 2) ? orders[o][1]
+                          : orders[o][2];
+                    if (f == 2) {
+                        continue;
+                    }
+                }
+                else if (canonical && perm[first] != 1) {
+                    break;
+                }
+                int total = base + lengths[o];
+                if (total <= w->shortest) {
+                    perm[tail] = orders[o][0];
+                    perm[tail + 1] = orders[o][1];
+                    perm[tail + 2] = orders[o][2];
+                }
+                count_tour(total, perm, n, best, w);
+            }
+            /* Leave the last order in place for next_perm(). */
+            perm[tail] = c;
+            perm[tail + 1] = b;
+            perm[tail + 2] = a;
+            k += 6;
+            rank += 6;
+        }
+        else {
+            /* Ragged ends of the range: one tour at a time. */
+            int x = perm[tail];
+            int y = perm[tail + 1];
+            int z = perm[tail + 2];
+            int f = (first < tail) ? perm[first]
+                  : (x == 1 || x == 2) ? x : (y == 1 || y == 2) ? y : z;
+            if (!canonical || f != 2) {
+                int total = base + row_q[x] + tsp[x * n + y] + tsp[y * n + z] + tsp[z * n + home];
+                count_tour(total, perm, n, best, w);
+            }
+            k++;
+            rank++;
+        }
+    }
+}
+
+/* One walk per size, with n fixed at compile time. */
+#define LEX_WALK(N)                                                             \
+    static void lex_walk_##N(const int *tsp, int n, int canonical, uint64_t first, \
+                             long count, int *best, walk_t *w) {                \
+        (void)n;                                                                \
+        walk_blocks(tsp, N, canonical, first, count, best, w);                  \
+    }
+
+LEX_WALK(8)
+LEX_WALK(9)
+LEX_WALK(10)
+LEX_WALK(11)
+LEX_WALK(12)
+LEX_WALK(13)
+LEX_WALK(14)
+LEX_WALK(15)
+LEX_WALK(16)
+
+static const lex_walk_t fixed_walks[FIXED_MAX - FIXED_MIN + 1] = {
+    lex_walk_8, lex_walk_9, lex_walk_10, lex_walk_11, lex_walk_12,
+    lex_walk_13, lex_walk_14, lex_walk_15, lex_walk_16
+};
+
+/* The specialized walk for n if there is one, else the generic walk. */
+lex_walk_t select_lex_walk(int n) {
+    const char *cap = getenv("LEX_WALK");
+    if (n < FIXED_MIN || n > FIXED_MAX || (cap != NULL && strcmp(cap, "generic") == 0)) {
+        lex_walk_name = "generic";
+        return lex_walk_generic;
+    }
+    lex_walk_name = "fixed";
+    return fixed_walks[n - FIXED_MIN];
+}
@@ -0,0 +1,24 @@
+/* Lexicographic tour walks specialized by city count; see fixed_size.c. */
+#include <stdint.h>
+
+/* City counts with a specialized walk. */
+#define FIXED_MIN 8
+#define FIXED_MAX 16
+
+/* What a walk found. */
+typedef struct {
+    int shortest;        /* Shortest tour length */
+    long num_as_short;   /* Tours of that length */
+    long num_trials;     /* Tours scored */
+} walk_t;
+
+/* Score 'count' tours of n cities in lexicographic order from rank 'first'
+   (from 0; in canonical mode, ranks of cities 1 .. n - 1 behind city 0,
+   and only canonical tours are scored). best[] gets the first shortest. */
+typedef void (*lex_walk_t)(const int *tsp, int n, int canonical, uint64_t first,
+                           long count, int *best, walk_t *w);
+
+extern lex_walk_t select_lex_walk(int n);
+extern void lex_walk_generic(const int *tsp, int n, int canonical, uint64_t first,
+                             long count, int *best, walk_t *w);
+extern const char *lex_walk_name;
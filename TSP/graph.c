@@ -0,0 +1,146 @@
+/**
+ * Distances between cities, dense or sparse.
+ *
+ * A dense graph is the usual n * n int matrix. A sparse one holds only the
+ * edges there are, in compressed sparse row (CSR) form: the edges out of
+ * each city are one contiguous run, sorted by the city they go to, so
+ * graph_dist() is a binary search of that run. A road network with a few
+ * edges per city takes O(n + m) memory instead of O(n * n). Costs may be
+ * asymmetric either way, and a pair with no edge costs TSP_MISSING(n).
+ *
+ * The exhaustive solvers take the dense matrix, which load_tsp() fills
+ * from a DIMACS file by the same convention, so any of them can run a
+ * sparse or one-way instance. The heuristics meant for large n (see
+ * local_search.c and lower_bound.c) take a graph_t instead and read it
+ * through graph_dist(), so their instances are loaded with load_graph(),
+ * which keeps a DIMACS file sparse, and no matrix is ever built for them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tsp.h"
+#include "tsp_file.h"
+#include "graph.h"
+
+/* Wrap an int matrix; the graph owns it from then on. */
+graph_t *dense_graph(int *tsp, int n) {
+    graph_t *g = calloc(1, sizeof(graph_t));
+    g->n = n;
+    g->dense = tsp;
+    g->missing = TSP_MISSING(n);
+    g->symmetric = is_symmetric(tsp, n);
+    return g;
+}
+
+static int by_from_to(const void *a, const void *b) {
+    const tsp_arc_t *x = a;
+    const tsp_arc_t *y = b;
+    if (x->from != y->from) {
+        return x->from < y->from ? -1 : 1;
+    }
+    if (x->to != y->to) {
+        return x->to < y->to ? -1 : 1;
+    }
+    return (x->cost > y->cost) - (x->cost < y->cost);
+}
+
+/* Build a sparse graph from arcs, which get sorted. Self loops are dropped
+   and of parallel arcs only the cheapest is kept. */
+graph_t *sparse_graph(tsp_arc_t *arcs, int n, long m) {
+    qsort(arcs, m, sizeof(tsp_arc_t), by_from_to);
+
+    graph_t *g = calloc(1, sizeof(graph_t));
+    g->n = n;
+    g->missing = TSP_MISSING(n);
+    g->row_start = calloc(n + 1, sizeof(long));
+    g->col = malloc((m > 0 ? m : 1) * sizeof(int));
+    g->cost = malloc((m > 0 ? m : 1) * sizeof(int));
+    long count = 0;
+    for (long k = 0; k < m; k++) {
+        tsp_arc_t *a = &arcs[k];
+        /* Sorted by cost last, so the first of a parallel run is cheapest. */
+        if (a->from == a->to || (k > 0 && a->from == arcs[k - 1].from && a->to == arcs[k - 1].to)) {
+            continue;
+        }
+        g->row_start[a->from + 1]++;
+        g->col[count] = a->to;
+        g->cost[count] = a->cost;
+        count++;
+    }
+    for (int i = 0; i < n; i++) {
+        g->row_start[i + 1] += g->row_start[i];
+    }
+
+    g->symmetric = 1;
+    for (int i = 0; i < n && g->symmetric; i++) {
+        for (long k = g->row_start[i]; k < g->row_start[i + 1]; k++) {
+            if (graph_dist(g, g->col[k], i) != g->cost[k]) {
+                g->symmetric = 0;
+                break;
+            }
+        }
+    }
+    return g;
+}
+
+/* Load an instance file. A DIMACS graph is kept sparse if 'sparse' is set;
+   anything else is read into a dense matrix by load_tsp(). */
+graph_t *load_graph(char *file_name, int sparse) {
+    int n;
+    long m;
+    tsp_arc_t *arcs = sparse ? read_dimacs(file_name, &n, &m) : NULL;
+    if (arcs == NULL) {
+        int *tsp = load_tsp(file_name, &n);
+        return dense_graph(tsp, n);
+    }
+    graph_t *g = sparse_graph(arcs, n, m);
+    free(arcs);
+    return g;
+}
+
+/* The full matrix, for the solvers that take one. Allocated dynamically;
+   the caller frees it. */
+int *graph_to_dense(graph_t *g) {
+    int n = g->n;
+    int *tsp = malloc((long)n * n * sizeof(int));
+    if (g->dense != NULL) {
+        memcpy(tsp, g->dense, (long)n * n * sizeof(int));
+        return tsp;
+    }
+    for (long k = 0; k < (long)n * n; k++) {
+        tsp[k] = g->missing;
+    }
+    for (int i = 0; i < n; i++) {
+        TSP_ELT(tsp, n, i, i) = 0;
+        for (long k = g->row_start[i]; k < g->row_start[i + 1]; k++) {
+            TSP_ELT(tsp, n, i, g->col[k]) = g->cost[k];
+        }
+    }
+    return tsp;
+}
+
+/* tour_length() through graph_dist(). */
+int graph_tour_length(graph_t *g, int *perm) {
+    int total = 0;
+    for (int i = 0; i < g->n - 1; i++) {
+        total += graph_dist(g, perm[i], perm[i + 1]);
+    }
+    return total + graph_dist(g, perm[g->n - 1], perm[0]);
+}
+
+/* Memory the distances take. */
+size_t graph_bytes(graph_t *g) {
+    if (g->dense != NULL) {
+        return (size_t)g->n * g->n * sizeof(int);
+    }
+    size_t m = g->row_start[g->n];
+    return (g->n + 1) * sizeof(long) + m * (sizeof(int) + sizeof(int));
+}
+
+void free_graph(graph_t *g) {
+    free(g->dense);
+    free(g->row_start);
+    free(g->col);
+    free(g->cost);
+    free(g);
+}
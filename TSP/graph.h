@@ -0,0 +1,46 @@
+/* Dense or sparse (CSR) distances behind one lookup; see graph.c. Needs
+   tsp_file.h first, for tsp_arc_t. */
+#include <stddef.h>
+
+typedef struct {
+    int n;
+    int symmetric;       /* Every edge costs the same both ways */
+    int missing;         /* Cost of a pair with no edge: TSP_MISSING(n); edges
+                            cost at most TSP_MAX_COST(n) */
+    int *dense;          /* n * n costs, row major, or NULL if sparse */
+    /* Sparse: the edges out of city i are col[k], cost[k] for k in
+       [row_start[i] .. row_start[i + 1]), in ascending order of col. */
+    long *row_start;
+    int *col;
+    int *cost;
+} graph_t;
+
+/* Cost of going from city i to city j. */
+static inline int graph_dist(const graph_t *g, int i, int j) {
+    if (g->dense != NULL) {
+        return g->dense[(long)i * g->n + j];
+    }
+    if (i == j) {
+        return 0;
+    }
+    long lo = g->row_start[i];
+    long hi = g->row_start[i + 1];
+    while (lo < hi) {
+        long mid = (lo + hi) / 2;
+        if (g->col[mid] < j) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return (lo < g->row_start[i + 1] && g->col[lo] == j) ? g->cost[lo] : g->missing;
+}
+
+extern graph_t *dense_graph(int *tsp, int n);
+extern graph_t *sparse_graph(tsp_arc_t *arcs, int n, long m);
+extern graph_t *load_graph(char *file_name, int sparse);
+extern int *graph_to_dense(graph_t *g);
+extern int graph_tour_length(graph_t *g, int *perm);
+extern size_t graph_bytes(graph_t *g);
+extern void free_graph(graph_t *g);
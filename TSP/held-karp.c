@@ -0,0 +1,304 @@
+/**
+ * Held-Karp dynamic programming TSP solver, O(n^2 2^n).
+ *
+ * City 0 is the fixed start. cost(S, j) is the length of the shortest path
+ * that leaves city 0, visits exactly the cities in S (a bitmask over cities
+ * 1 .. n - 1) and ends at j in S:
+ *
+ *     cost({j}, j) = d(0, j)
+ *     cost(S, j)   = min over k in S - {j} of cost(S - {j}, k) + d(k, j)
+ *
+ * The table is stored mask-major, so the n - 1 costs of one subset sit side
+ * by side and the inner min over k reads one contiguous row. Subsets are
+ * computed in order of size; every subset of a size only depends on the
+ * previous size, so each layer is split across threads with a barrier in
+ * between. Costs are kept in 16 bits when n times the largest distance
+ * fits, halving the table, and distances are read at the width they are
+ * stored in (see tsp_file.c); the relaxation is built for each pair.
+ *
+ * Build: gcc -std=gnu99 -O2 -pthread held-karp.c tsp.c perm.c tsp_file.c -lm
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+
+/* 2^24 subsets of 24 end cities is already 800MB at 16 bits per cost. */
+#define MAX_CITIES 25
+
+/* Per-thread state */
+typedef struct {
+    int id;
+} mystery_box_t;
+
+int num_cities = 5;
+int num_threads = 1;
+int random_seed = 42;
+
+tsp_file_t *instance;      /* Distances at their stored width */
+int m;                     /* Cities other than the start: n - 1 */
+long binomial[MAX_CITIES][MAX_CITIES];
+pthread_barrier_t layer_barrier;
+
+/* The DP table is one of these, depending on the distance range. */
+int use_narrow;
+uint16_t *cost16;
+uint32_t *cost32;
+
+#define COST(mask, j) (use_narrow ? cost16[(mask) * m + (j)] : cost32[(mask) * m + (j)])
+
+/* Fill the table of binomial coefficients C(i, k), i < MAX_CITIES. */
+void init_binomial(void) {
+    for (int i = 0; i < MAX_CITIES; i++) {
+        binomial[i][0] = 1;
+        for (int k = 1; k <= i; k++) {
+            binomial[i][k] = binomial[i - 1][k - 1] + (k < i ? binomial[i - 1][k] : 0);
+        }
+    }
+}
+
+/* Return the index-th (from 0) mask of 'size' bits set in colexicographic
+   order, which is the order Gosper's hack walks them in. */
+unsigned int nth_subset(int size, long index) {
+    unsigned int mask = 0;
+    for (int bit = m - 1; size > 0; bit--) {
+        long below = (bit >= size) ? binomial[bit][size] : 0;
+        if (index >= below) {
+            mask |= 1u << bit;
+            index -= below;
+            size--;
+        }
+    }
+    return mask;
+}
+
+/* Next larger mask with the same number of bits set (Gosper's hack). */
+unsigned int next_subset(unsigned int mask) {
+    unsigned int low = mask & -mask;
+    unsigned int ripple = mask + low;
+    return ripple | (((mask ^ ripple) >> 2) / low);
+}
+
+/* Generate a relaxation routine for one cost type and one distance type.
+   Both are fixed per run, so the branch in COST() and the width of the
+   distances stay out of the hot loop. */
+#define DEFINE_RELAX(type, table, dname, dtype)                              \
+    void relax_##type##_##dname(unsigned int mask) {                         \
+        for (int j = 0; j < m; j++) {                                        \
+            if (!(mask & (1u << j))) {                                       \
+                continue;                                                    \
+            }                                                                \
+            unsigned int prev = mask & ~(1u << j);                           \
+            type *row = table + (long)prev * m;                              \
+            const dtype *to_j = (const dtype *)instance->data + j + 1;       \
+            unsigned int best = UINT_MAX;                                    \
+            for (unsigned int bits = prev; bits; bits &= bits - 1) {         \
+                int k = __builtin_ctz(bits);                                 \
+                unsigned int c = row[k] + to_j[(k + 1) * num_cities];        \
+                best = (c < best) ? c : best;                                \
+            }                                                                \
+            table[(long)mask * m + j] = (type)best;                          \
+        }                                                                    \
+    }
+
+DEFINE_RELAX(uint16_t, cost16, u8, uint8_t)
+DEFINE_RELAX(uint16_t, cost16, u16, uint16_t)
+DEFINE_RELAX(uint16_t, cost16, i32, int)
+DEFINE_RELAX(uint32_t, cost32, u8, uint8_t)
+DEFINE_RELAX(uint32_t, cost32, u16, uint16_t)
+DEFINE_RELAX(uint32_t, cost32, i32, int)
+
+/* The relaxation for this run's cost and distance types. */
+void (*relax)(unsigned int mask);
+
+/* Compute every layer of the table; each thread takes a contiguous share of
+   the subsets of each size. */
+void *held_karp(void *parameter) {
+    mystery_box_t *my_box = (mystery_box_t *)parameter;
+
+    for (int size = 2; size <= m; size++) {
+        long count = binomial[m][size];
+        long share = count / num_threads;
+        long extra = count % num_threads;
+        long start = share * my_box->id + (my_box->id < extra ? my_box->id : extra);
+        long load = share + (my_box->id < extra ? 1 : 0);
+
+        if (load > 0) {
+            unsigned int mask = nth_subset(size, start);
+            for (long i = 0; i < load; i++) {
+                relax(mask);
+                mask = next_subset(mask);
+            }
+        }
+        pthread_barrier_wait(&layer_barrier);
+    }
+    return NULL;
+}
+
+/* Walk the table back from the full set to recover an optimal tour. */
+int recover_tour(int *tour) {
+    unsigned int mask = (1u << m) - 1;
+    int shortest = INT_MAX;
+    int last = 0;
+
+    for (int j = 0; j < m; j++) {
+        int len = COST(mask, j) + tsp_dist(instance, j + 1, 0);
+        if (len < shortest) {
+            shortest = len;
+            last = j;
+        }
+    }
+
+    tour[0] = 0;
+    for (int pos = m; pos >= 1; pos--) {
+        tour[pos] = last + 1;
+        unsigned int prev = mask & ~(1u << last);
+        if (prev == 0) {
+            break;
+        }
+        for (int k = 0; k < m; k++) {
+            if ((prev & (1u << k)) &&
+                COST(prev, k) + tsp_dist(instance, k + 1, last + 1) == COST(mask, last)) {
+                last = k;
+                break;
+            }
+        }
+        mask = prev;
+    }
+    return shortest;
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
+    fprintf(stderr, "   -n <number of threads>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *tsp_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:hn:s:")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'n':
+            num_threads = atoi(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (tsp_file_name != NULL) {
+        instance = tsp_open(tsp_file_name);
+        num_cities = instance->n;
+    }
+    else {
+        instance = tsp_random(num_cities, random_seed);
+    }
+    if (num_cities < 3 || num_cities > MAX_CITIES) {
+        fprintf(stderr, "Number of cities must be in [3 .. %d]\n", MAX_CITIES);
+        exit(1);
+    }
+    if (num_threads < 1) {
+        fprintf(stderr, "Invalid thread count, exiting...\n");
+        exit(1);
+    }
+
+    tsp_print(instance, random_seed);
+
+    /* Pick the narrowest cost type that holds any path. */
+    int max_dist = 0;
+    for (int i = 0; i < num_cities; i++) {
+        for (int j = 0; j < num_cities; j++) {
+            max_dist = (tsp_dist(instance, i, j) > max_dist) ? tsp_dist(instance, i, j) : max_dist;
+        }
+    }
+    m = num_cities - 1;
+    use_narrow = ((long)max_dist * num_cities < UINT16_MAX);
+    if (instance->elt_size == 1) {
+        relax = use_narrow ? relax_uint16_t_u8 : relax_uint32_t_u8;
+    }
+    else if (instance->elt_size == 2) {
+        relax = use_narrow ? relax_uint16_t_u16 : relax_uint32_t_u16;
+    }
+    else {
+        relax = use_narrow ? relax_uint16_t_i32 : relax_uint32_t_i32;
+    }
+    size_t entries = ((size_t)1 << m) * m;
+    size_t bytes = entries * (use_narrow ? sizeof(uint16_t) : sizeof(uint32_t));
+    printf("DP table: %zu entries of %d bits (%.1f MB)\n",
+           entries, use_narrow ? 16 : 32, bytes / 1048576.0);
+    if (use_narrow) {
+        cost16 = malloc(bytes);
+    }
+    else {
+        cost32 = malloc(bytes);
+    }
+    if (cost16 == NULL && cost32 == NULL) {
+        fprintf(stderr, "Can't allocate the DP table\n");
+        exit(1);
+    }
+
+    init_binomial();
+    double start_time = now();
+
+    /* Paths straight from city 0. */
+    for (int j = 0; j < m; j++) {
+        unsigned int mask = 1u << j;
+        int val = tsp_dist(instance, 0, j + 1);
+        if (use_narrow) {
+            cost16[(long)mask * m + j] = val;
+        }
+        else {
+            cost32[(long)mask * m + j] = val;
+        }
+    }
+
+    pthread_t threads[num_threads];
+    mystery_box_t boxes[num_threads];
+    pthread_barrier_init(&layer_barrier, NULL, num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        boxes[i].id = i;
+        pthread_create(&threads[i], NULL, held_karp, &boxes[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&layer_barrier);
+
+    int tour[num_cities];
+    int shortest = recover_tour(tour);
+    double elapsed = now() - start_time;
+
+    /* Report. */
+    printf("\n");
+    print_perm(tour, num_cities);
+    printf("Shortest %d\n", shortest);
+    if (tsp_tour_length(instance, tour) != shortest) {
+        fprintf(stderr, "Recovered tour does not have the optimal length\n");
+    }
+    printf("Program took %5.3f seconds to run on %d threads.\n", elapsed, num_threads);
+
+    free(cost16);
+    free(cost32);
+    tsp_close(instance);
+    return 0;
+}
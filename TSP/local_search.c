@@ -0,0 +1,451 @@
+/**
+ * Heuristic TSP tours for instances far too large to enumerate.
+ *
+ * A tour is built greedily by nearest neighbour and then improved by 2-opt
+ * (replace two edges by the two that reconnect the tour the other way) and
+ * Or-opt (move a run of up to three cities elsewhere, either way round)
+ * until no move helps. Two standard tricks keep each pass cheap:
+ *
+ *   - Neighbour lists: a move must add an edge from a city to one of its k
+ *     nearest cities, and the lists are scanned only while that edge is
+ *     shorter than the one it would replace.
+ *
+ *   - Don't-look bits: only cities on a queue are tried. A city leaves the
+ *     queue when nothing improves around it and comes back when a move
+ *     changes one of its edges.
+ *
+ * The tour is an array plus each city's position in it, so a 2-opt move
+ * reverses the shorter side of the cycle and an Or-opt move is two or three
+ * 2-opt moves. Moves assume symmetric distances.
+ *
+ * Distances come through graph_dist(), so a sparse road network is never
+ * widened into a matrix. Its neighbour lists are the cheapest edges of
+ * each city's CSR row, and the tour builders look along that row, so only
+ * the moves themselves pay a binary search per lookup. A city with fewer
+ * than k edges is padded with the lowest numbered others, at TSP_MISSING(n)
+ * each, which is where a dense scan of the same graph puts them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "tsp_file.h"
+#include "graph.h"
+#include "local_search.h"
+
+/* Longest run of cities an Or-opt move relocates. */
+#define OR_OPT_MAX 3
+
+/* Candidates random_neighbour_tour() picks the next city from. */
+#define RANDOM_CHOICES 3
+
+typedef struct {
+    int n;
+    graph_t *g;
+    int *tour;
+    int *pos;       /* Position of each city in tour[] */
+    int *queue;     /* Cities whose don't-look bit is off, FIFO */
+    char *queued;
+    int head;
+    int count;
+} ls_state_t;
+
+#define D(s, i, j) graph_dist((s)->g, i, j)
+
+static inline int succ(ls_state_t *s, int c) {
+    int p = s->pos[c] + 1;
+    return s->tour[p == s->n ? 0 : p];
+}
+
+static inline int pred(ls_state_t *s, int c) {
+    int p = s->pos[c];
+    return s->tour[p == 0 ? s->n - 1 : p - 1];
+}
+
+/* Turn the don't-look bit of city c off. */
+static void push(ls_state_t *s, int c) {
+    if (!s->queued[c]) {
+        int tail = s->head + s->count;
+        s->queue[tail >= s->n ? tail - s->n : tail] = c;
+        s->queued[c] = 1;
+        s->count++;
+    }
+}
+
+static int pop(ls_state_t *s) {
+    int c = s->queue[s->head];
+    s->head = (s->head + 1 == s->n) ? 0 : s->head + 1;
+    s->count--;
+    s->queued[c] = 0;
+    return c;
+}
+
+/* Reverse tour positions i .. j, going forward and wrapping around. The
+   rest of the cycle reversed is the same tour, so do whichever is shorter. */
+static void reverse(ls_state_t *s, int i, int j) {
+    int n = s->n;
+    int len = j - i;
+    if (len < 0) {
+        len += n;
+    }
+    len++;
+    if (2 * len > n) {
+        int t = i;
+        i = (j + 1 == n) ? 0 : j + 1;
+        j = (t == 0) ? n - 1 : t - 1;
+        len = n - len;
+    }
+    for (int k = 0; k < len / 2; k++) {
+        int ci = s->tour[i];
+        int cj = s->tour[j];
+        s->tour[i] = cj;
+        s->pos[cj] = i;
+        s->tour[j] = ci;
+        s->pos[ci] = j;
+        i = (i + 1 == n) ? 0 : i + 1;
+        j = (j == 0) ? n - 1 : j - 1;
+    }
+}
+
+/* Replace edges a-b and c-d by a-c and b-d. b and d must follow a and c in
+   the same direction around the tour, whichever direction that is. */
+static void two_opt_move(ls_state_t *s, int a, int b, int c, int d) {
+    if (succ(s, a) == b) {
+        reverse(s, s->pos[b], s->pos[c]);
+    }
+    else {
+        reverse(s, s->pos[a], s->pos[d]);
+    }
+}
+
+/* Try 2-opt moves that add an edge from city a to one of its neighbours.
+   Make the first that helps and return its change in length, or 0. */
+static int improve_2opt(ls_state_t *s, int a, int *neighbours, int k) {
+    for (int dir = 0; dir < 2; dir++) {
+        int b = dir ? pred(s, a) : succ(s, a);
+        int d_ab = D(s, a, b);
+        for (int i = 0; i < k; i++) {
+            int c = neighbours[a * k + i];
+            int d_ac = D(s, a, c);
+            if (d_ac >= d_ab) {
+                break;
+            }
+            int d = dir ? pred(s, c) : succ(s, c);
+            if (c == b || d == a) {
+                continue;
+            }
+            int delta = d_ac + D(s, b, d) - d_ab - D(s, c, d);
+            if (delta < 0) {
+                two_opt_move(s, a, b, c, d);
+                push(s, a);
+                push(s, b);
+                push(s, c);
+                push(s, d);
+                return delta;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Move the run s1 .. s2 (p before it, nx after it) between the adjacent
+   cities c and y, with city 'near' next to c. */
+static void move_segment(ls_state_t *s, int s1, int s2, int p, int nx,
+                         int c, int y, int near) {
+    /* Name the target edge c0-e0 with e0 following c0, the same way s2
+       follows s1. */
+    int c0 = c;
+    int e0 = y;
+    if (y != succ(s, c)) {
+        c0 = y;
+        e0 = c;
+        near = (near == s1) ? s2 : s1;
+    }
+    /* The moves below need the run to come before c0-e0; if it comes
+       right after, look at the tour the other way round. */
+    if (e0 == p) {
+        near = (near == s1) ? s2 : s1;
+        int t = s1;
+        s1 = s2;
+        s2 = t;
+        t = p;
+        p = nx;
+        nx = t;
+        t = c0;
+        c0 = e0;
+        e0 = t;
+    }
+
+    /* p s1..s2 nx .. c0 e0  becomes  p c0 .. nx s2..s1 e0 */
+    two_opt_move(s, p, s1, c0, e0);
+    /* then  p nx .. c0 s2..s1 e0 */
+    if (c0 != nx) {
+        two_opt_move(s, p, c0, nx, s2);
+    }
+    /* and  p nx .. c0 s1..s2 e0  if s1 belongs next to c0 */
+    if (near == s1 && s1 != s2) {
+        two_opt_move(s, c0, s2, s1, e0);
+    }
+}
+
+/* Try Or-opt moves of runs of up to OR_OPT_MAX cities that start or end at
+   city a. Make the first that helps and return its change in length, or 0. */
+static int improve_or_opt(ls_state_t *s, int a, int *neighbours, int k) {
+    int n = s->n;
+    for (int len = 1; len <= OR_OPT_MAX && len + 3 <= n; len++) {
+        for (int end = 0; end < (len > 1 ? 2 : 1); end++) {
+            int s1 = a;
+            int s2 = a;
+            for (int i = 1; i < len; i++) {
+                if (end) {
+                    s1 = pred(s, s1);
+                }
+                else {
+                    s2 = succ(s, s2);
+                }
+            }
+            int p = pred(s, s1);
+            int nx = succ(s, s2);
+            int gain = D(s, p, s1) + D(s, s2, nx) - D(s, p, nx);
+            if (gain <= 0) {
+                continue;
+            }
+            int first = s->pos[s1];
+
+            /* Join either end of the run to a neighbour c, on either side
+               of c. */
+            for (int side = 0; side < (len > 1 ? 2 : 1); side++) {
+                int u = side ? s2 : s1;
+                int v = side ? s1 : s2;
+                for (int i = 0; i < k; i++) {
+                    int c = neighbours[u * k + i];
+                    int d_uc = D(s, u, c);
+                    if (d_uc >= gain) {
+                        break;
+                    }
+                    int off = s->pos[c] - first;
+                    if ((off < 0 ? off + n : off) < len) {
+                        continue;
+                    }
+                    for (int adj = 0; adj < 2; adj++) {
+                        int y = adj ? pred(s, c) : succ(s, c);
+                        off = s->pos[y] - first;
+                        if ((off < 0 ? off + n : off) < len) {
+                            continue;
+                        }
+                        int delta = d_uc + D(s, v, y) - D(s, c, y) - gain;
+                        if (delta < 0) {
+                            move_segment(s, s1, s2, p, nx, c, y, u);
+                            push(s, p);
+                            push(s, nx);
+                            push(s, s1);
+                            push(s, s2);
+                            push(s, c);
+                            push(s, y);
+                            return delta;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* Insert city j at cost d into the sorted list of 'found' cities, keeping
+   at most k; ties keep the earlier city first. Returns the new count. */
+static int insert_nearest(int *list, int *costs, int found, int k, int j, int d) {
+    if (found == k && d >= costs[k - 1]) {
+        return found;
+    }
+    /* Insertion into the sorted list, dropping the farthest. */
+    int at = (found < k) ? found++ : k - 1;
+    while (at > 0 && costs[at - 1] > d) {
+        list[at] = list[at - 1];
+        costs[at] = costs[at - 1];
+        at--;
+    }
+    list[at] = j;
+    costs[at] = d;
+    return found;
+}
+
+/* Return the k nearest other cities of each city, nearest first, as an
+   n * k array. Allocated dynamically; the caller frees it. */
+int *neighbour_lists(graph_t *g, int k) {
+    int n = g->n;
+    int *neighbours = malloc((long)n * k * sizeof(int));
+    int *costs = malloc(k * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int *list = neighbours + (long)i * k;
+        int found = 0;
+        if (g->dense != NULL) {
+            const int *row = g->dense + (long)i * n;
+            for (int j = 0; j < n; j++) {
+                if (j != i) {
+                    found = insert_nearest(list, costs, found, k, j, row[j]);
+                }
+            }
+            continue;
+        }
+
+        long first = g->row_start[i];
+        long last = g->row_start[i + 1];
+        for (long e = first; e < last; e++) {
+            found = insert_nearest(list, costs, found, k, g->col[e], g->cost[e]);
+        }
+        /* Pad with the cities there is no edge to, in order. */
+        for (int j = 0; j < n && found < k; j++) {
+            while (first < last && g->col[first] < j) {
+                first++;
+            }
+            if (j != i && (first == last || g->col[first] != j)) {
+                list[found++] = j;
+            }
+        }
+    }
+    free(costs);
+    return neighbours;
+}
+
+/* The nearest city to cur not yet visited; ties go to the lowest number.
+   Cities below *unvisited have all been visited, and it is kept so. */
+static int nearest_unvisited(graph_t *g, int cur, const char *visited, int *unvisited) {
+    int next = -1;
+    int best = INT_MAX;
+    if (g->dense != NULL) {
+        const int *row = g->dense + (long)cur * g->n;
+        for (int j = 0; j < g->n; j++) {
+            if (!visited[j] && row[j] < best) {
+                best = row[j];
+                next = j;
+            }
+        }
+        return next;
+    }
+
+    /* Every edge beats a missing one, so only with none left does the
+       lowest unvisited city win. */
+    for (long e = g->row_start[cur]; e < g->row_start[cur + 1]; e++) {
+        if (!visited[g->col[e]] && g->cost[e] < best) {
+            best = g->cost[e];
+            next = g->col[e];
+        }
+    }
+    if (next < 0) {
+        while (visited[*unvisited]) {
+            (*unvisited)++;
+        }
+        next = *unvisited;
+    }
+    return next;
+}
+
+/* Build a tour from 'start' by always going to the nearest unvisited city.
+   Returns its length. */
+int nearest_neighbour_tour(graph_t *g, int start, int *tour) {
+    int n = g->n;
+    char *visited = calloc(n, 1);
+    int unvisited = 0;
+    int total = 0;
+    int cur = start;
+
+    tour[0] = start;
+    visited[start] = 1;
+    for (int i = 1; i < n; i++) {
+        int next = nearest_unvisited(g, cur, visited, &unvisited);
+        tour[i] = next;
+        visited[next] = 1;
+        total += graph_dist(g, cur, next);
+        cur = next;
+    }
+    free(visited);
+    return total + graph_dist(g, cur, start);
+}
+
+/* Randomized nearest neighbour: start at a random city, then step to one
+   of the (up to) RANDOM_CHOICES nearest unvisited cities at random. Falls
+   back to the nearest unvisited city when none of a city's neighbours is
+   left. Different generators give different, but all reasonable, starting
+   tours. */
+int random_neighbour_tour(graph_t *g, int *neighbours, int k,
+                          rng_t *rng, int *tour) {
+    int n = g->n;
+    char *visited = calloc(n, 1);
+    int unvisited = 0;
+    int cur = rng_below(rng, n);
+    int start = cur;
+    int total = 0;
+
+    tour[0] = cur;
+    visited[cur] = 1;
+    for (int i = 1; i < n; i++) {
+        int choices[RANDOM_CHOICES];
+        int found = 0;
+        for (int j = 0; j < k && found < RANDOM_CHOICES; j++) {
+            int c = neighbours[(long)cur * k + j];
+            if (!visited[c]) {
+                choices[found++] = c;
+            }
+        }
+        int next;
+        if (found > 0) {
+            next = choices[rng_below(rng, found)];
+        }
+        else {
+            next = nearest_unvisited(g, cur, visited, &unvisited);
+        }
+        tour[i] = next;
+        visited[next] = 1;
+        total += graph_dist(g, cur, next);
+        cur = next;
+    }
+    free(visited);
+    return total + graph_dist(g, cur, start);
+}
+
+/* Improve tour[] in place with 2-opt and Or-opt moves until none helps,
+   using the k nearest neighbours of each city from neighbour_lists().
+   Calls 'action' (if not NULL) after every improving move, and adds the
+   number of moves made to *num_moves. Returns the final length. */
+int local_search(graph_t *g, int *neighbours, int k, int *tour,
+                 long *num_moves, improve_action_t action, void *arg) {
+    int n = g->n;
+    int length = graph_tour_length(g, tour);
+    if (n < 4) {
+        return length;
+    }
+
+    ls_state_t s;
+    s.n = n;
+    s.g = g;
+    s.tour = tour;
+    s.pos = malloc(n * sizeof(int));
+    s.queue = malloc(n * sizeof(int));
+    s.queued = calloc(n, 1);
+    s.head = 0;
+    s.count = 0;
+    for (int i = 0; i < n; i++) {
+        s.pos[tour[i]] = i;
+        push(&s, tour[i]);
+    }
+
+    while (s.count > 0) {
+        int a = pop(&s);
+        int delta = improve_2opt(&s, a, neighbours, k);
+        if (delta == 0) {
+            delta = improve_or_opt(&s, a, neighbours, k);
+        }
+        if (delta < 0) {
+            length += delta;
+            (*num_moves)++;
+            if (action != NULL) {
+                action(length, arg);
+            }
+        }
+    }
+
+    free(s.pos);
+    free(s.queue);
+    free(s.queued);
+    return length;
+}
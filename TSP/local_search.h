@@ -0,0 +1,13 @@
+/* Heuristic tour construction and improvement; see local_search.c. Needs
+   graph.h first, for graph_t. */
+#include "rng.h"
+
+/* Called after every improving move with the new tour length. */
+typedef void (*improve_action_t)(int length, void *arg);
+
+extern int *neighbour_lists(graph_t *g, int k);
+extern int nearest_neighbour_tour(graph_t *g, int start, int *tour);
+extern int random_neighbour_tour(graph_t *g, int *neighbours, int k,
+                                 rng_t *rng, int *tour);
+extern int local_search(graph_t *g, int *neighbours, int k, int *tour,
+                        long *num_moves, improve_action_t action, void *arg);
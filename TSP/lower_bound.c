@@ -0,0 +1,332 @@
+/**
+ * Lower bounds on the length of a tour.
+ *
+ * A 1-tree is a spanning tree of cities 1 .. n - 1 plus the two cheapest
+ * edges at city 0. Every tour is a 1-tree, so the minimum 1-tree is a lower
+ * bound. Adding a penalty pi[i] to every edge at city i adds exactly
+ * 2 * sum(pi) to every tour but changes which 1-tree is cheapest, so
+ *
+ *     min 1-tree under d(i, j) + pi[i] + pi[j]  -  2 * sum(pi)
+ *
+ * is a bound for any pi. held_karp_bound() climbs towards the best pi by
+ * subgradient steps (Held and Karp), raising the penalty of cities of
+ * degree above 2 and lowering it below 2.
+ *
+ * path_bound() applies the same penalties to a partial tour: whatever path
+ * completes it through the unplaced cities is a spanning tree of those
+ * cities and its two ends, so the minimum spanning tree bounds it.
+ *
+ * Trees are built by Prim's algorithm over every pair of cities. Each step
+ * lowers the keys of the cities still outside the tree and picks the
+ * smallest, which is one vector pass with AVX2 (gathered distances,
+ * masked min). The version is picked at run time, as in batch_eval.c.
+ * A step reads the row of the city just added: straight from a dense
+ * graph, or scattered from a sparse one into a scratch row that is
+ * otherwise all TSP_MISSING(n), so a road network needs O(n) memory here
+ * rather than a matrix. Distances must be symmetric.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "tsp_file.h"
+#include "graph.h"
+#include "lower_bound.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+/* Subgradient steps without a better bound before the step size halves. */
+#define PATIENCE 20
+
+/* Add position u, of penalty pu, to the tree: lower the key (and set the
+   parent) of every position not yet in it whose edge to u is cheaper, and
+   return the position with the smallest key. Positions in the tree have
+   done[] set and a key of INT_MAX. */
+typedef int (*prim_step_t)(const int *row, const int *cities, const int *pic, int pu,
+                           int *key, int *parent, const int *done, int u, int m);
+
+const char *prim_step_name = "scalar";
+
+static int prim_step_scalar(const int *row, const int *cities, const int *pic, int pu,
+                            int *key, int *parent, const int *done, int u, int m) {
+    int best = INT_MAX;
+    int at = -1;
+    for (int j = 0; j < m; j++) {
+        int c = row[cities[j]] + pic[j] + pu;
+        if (!done[j] && c < key[j]) {
+            key[j] = c;
+            parent[j] = u;
+        }
+        if (key[j] < best) {
+            best = key[j];
+            at = j;
+        }
+    }
+    return at;
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("avx2")))
+static int prim_step_avx2(const int *row, const int *cities, const int *pic, int pu,
+                          int *key, int *parent, const int *done, int u, int m) {
+    const __m256i vpu = _mm256_set1_epi32(pu);
+    const __m256i vu = _mm256_set1_epi32(u);
+    __m256i vbest = _mm256_set1_epi32(INT_MAX);
+    int j = 0;
+    for (; j + 8 <= m; j += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i *)(cities + j));
+        __m256i c = _mm256_i32gather_epi32(row, idx, 4);
+        c = _mm256_add_epi32(c, _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(pic + j)), vpu));
+        __m256i k = _mm256_loadu_si256((const __m256i *)(key + j));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(done + j));
+        __m256i lower = _mm256_andnot_si256(d, _mm256_cmpgt_epi32(k, c));
+        k = _mm256_blendv_epi8(k, c, lower);
+        _mm256_storeu_si256((__m256i *)(key + j), k);
+        __m256i p = _mm256_loadu_si256((const __m256i *)(parent + j));
+        _mm256_storeu_si256((__m256i *)(parent + j), _mm256_blendv_epi8(p, vu, lower));
+        vbest = _mm256_min_epi32(vbest, k);
+    }
+
+    /* Horizontal min, then the tail. */
+    __m128i b = _mm_min_epi32(_mm256_castsi256_si128(vbest), _mm256_extracti128_si256(vbest, 1));
+    b = _mm_min_epi32(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2)));
+    b = _mm_min_epi32(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 3, 0, 1)));
+    int best = _mm_cvtsi128_si32(b);
+    for (; j < m; j++) {
+        int c = row[cities[j]] + pic[j] + pu;
+        if (!done[j] && c < key[j]) {
+            key[j] = c;
+            parent[j] = u;
+        }
+        best = (key[j] < best) ? key[j] : best;
+    }
+
+    /* First position holding the min, as the scalar version picks. */
+    if (best == INT_MAX) {
+        return -1;
+    }
+    for (j = 0; key[j] != best; j++) {
+    }
+    return j;
+}
+#endif
+
+static prim_step_t prim_step = NULL;
+
+/* Use AVX2 if the CPU has it, unless PRIM_STEP=scalar is set in the
+   environment, for cross checks. */
+static void select_prim_step(void) {
+    const char *cap = getenv("PRIM_STEP");
+    prim_step = prim_step_scalar;
+    prim_step_name = "scalar";
+    if (cap != NULL && strcmp(cap, "scalar") == 0) {
+        return;
+    }
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        prim_step = prim_step_avx2;
+        prim_step_name = "avx2";
+    }
+#endif
+}
+
+/* Allocated dynamically; free with free_lower_bound(). */
+lower_bound_t *create_lower_bound(graph_t *g) {
+    if (prim_step == NULL) {
+        select_prim_step();
+    }
+    int n = g->n;
+    lower_bound_t *lb = malloc(sizeof(lower_bound_t));
+    lb->n = n;
+    lb->g = g;
+    lb->pi = calloc(n, sizeof(int));
+    lb->iterations = 0;
+    lb->cities = malloc(n * sizeof(int));
+    lb->pic = malloc(n * sizeof(int));
+    lb->key = malloc(n * sizeof(int));
+    lb->parent = malloc(n * sizeof(int));
+    lb->done = malloc(n * sizeof(int));
+    lb->degree = malloc(n * sizeof(int));
+    lb->row = NULL;
+    if (g->dense == NULL) {
+        lb->row = malloc(n * sizeof(int));
+        for (int j = 0; j < n; j++) {
+            lb->row[j] = g->missing;
+        }
+    }
+    return lb;
+}
+
+void free_lower_bound(lower_bound_t *lb) {
+    free(lb->pi);
+    free(lb->cities);
+    free(lb->pic);
+    free(lb->key);
+    free(lb->parent);
+    free(lb->done);
+    free(lb->degree);
+    free(lb->row);
+    free(lb);
+}
+
+/* Minimum spanning tree of lb->cities[0 .. m - 1] under penalized costs,
+   rooted at position 0; lb->parent[] holds the tree. Returns its weight. */
+static int spanning_tree(lower_bound_t *lb, int m) {
+    int n = lb->n;
+    for (int j = 0; j < m; j++) {
+        lb->pic[j] = lb->pi[lb->cities[j]];
+        lb->key[j] = INT_MAX;
+        lb->done[j] = 0;
+    }
+
+    int weight = 0;
+    int u = 0;
+    lb->parent[0] = -1;
+    for (int added = 1; ; added++) {
+        lb->done[u] = -1;
+        lb->key[u] = INT_MAX;
+        if (added == m) {
+            break;
+        }
+        int city = lb->cities[u];
+        graph_t *g = lb->g;
+        if (g->dense != NULL) {
+            u = prim_step(g->dense + (long)city * n, lb->cities, lb->pic, lb->pi[city],
+                          lb->key, lb->parent, lb->done, u, m);
+        }
+        else {
+            long first = g->row_start[city];
+            long last = g->row_start[city + 1];
+            for (long e = first; e < last; e++) {
+                lb->row[g->col[e]] = g->cost[e];
+            }
+            u = prim_step(lb->row, lb->cities, lb->pic, lb->pi[city],
+                          lb->key, lb->parent, lb->done, u, m);
+            for (long e = first; e < last; e++) {
+                lb->row[g->col[e]] = g->missing;
+            }
+        }
+        weight += lb->key[u];
+    }
+    return weight;
+}
+
+/* Bound from the minimum 1-tree under the current penalties. Leaves each
+   city's degree in the 1-tree in lb->degree[]. */
+int one_tree_bound(lower_bound_t *lb) {
+    int n = lb->n;
+    if (n < 3) {
+        int perm[2] = { 0, 1 };
+        return graph_tour_length(lb->g, perm);
+    }
+
+    for (int j = 0; j < n - 1; j++) {
+        lb->cities[j] = j + 1;
+    }
+    int weight = spanning_tree(lb, n - 1);
+    memset(lb->degree, 0, n * sizeof(int));
+    for (int j = 1; j < n - 1; j++) {
+        lb->degree[lb->cities[j]]++;
+        lb->degree[lb->cities[lb->parent[j]]]++;
+    }
+
+    /* The two cheapest edges at city 0. */
+    int first = -1;
+    int second = -1;
+    int c1 = INT_MAX;
+    int c2 = INT_MAX;
+    for (int j = 1; j < n; j++) {
+        int c = graph_dist(lb->g, 0, j) + lb->pi[0] + lb->pi[j];
+        if (c < c1) {
+            c2 = c1;
+            second = first;
+            c1 = c;
+            first = j;
+        }
+        else if (c < c2) {
+            c2 = c;
+            second = j;
+        }
+    }
+    lb->degree[0] = 2;
+    lb->degree[first]++;
+    lb->degree[second]++;
+
+    int penalty = 0;
+    for (int i = 0; i < n; i++) {
+        penalty += lb->pi[i];
+    }
+    return weight + c1 + c2 - 2 * penalty;
+}
+
+/* Held-Karp bound: subgradient ascent on the 1-tree bound for at most
+   max_iterations steps. 'upper' is the length of any known tour and sets
+   the step size. Leaves the best penalties found in lb->pi. */
+int held_karp_bound(lower_bound_t *lb, int upper, int max_iterations) {
+    int n = lb->n;
+    if (n < 3) {
+        lb->iterations = 0;
+        return one_tree_bound(lb);
+    }
+    double *pi = calloc(n, sizeof(double));
+    int *best_pi = calloc(n, sizeof(int));
+    int best = INT_MIN;
+    double lambda = 2.0;
+    int since_better = 0;
+
+    memset(lb->pi, 0, n * sizeof(int));
+    for (lb->iterations = 0; lb->iterations < max_iterations; lb->iterations++) {
+        int bound = one_tree_bound(lb);
+        if (bound > best) {
+            best = bound;
+            memcpy(best_pi, lb->pi, n * sizeof(int));
+            since_better = 0;
+        }
+        else if (++since_better >= PATIENCE) {
+            lambda /= 2;
+            since_better = 0;
+        }
+
+        int norm = 0;
+        for (int i = 0; i < n; i++) {
+            norm += (lb->degree[i] - 2) * (lb->degree[i] - 2);
+        }
+        /* Every degree 2 means the 1-tree is a tour, hence optimal. */
+        if (norm == 0 || bound >= upper || lambda < 1e-3) {
+            lb->iterations++;
+            break;
+        }
+        double step = lambda * (upper - bound) / norm;
+        for (int i = 0; i < n; i++) {
+            pi[i] += step * (lb->degree[i] - 2);
+            lb->pi[i] = (int)lround(pi[i]);
+        }
+    }
+
+    memcpy(lb->pi, best_pi, n * sizeof(int));
+    free(pi);
+    free(best_pi);
+    return best;
+}
+
+/* Bound on the shortest path from 'last' through cities[0 .. m - 1] to
+   'first', using the penalties already in lb->pi (all zero, or left by
+   held_karp_bound()). When first == last the path closes into a cycle. */
+int path_bound(lower_bound_t *lb, int *cities, int m, int first, int last) {
+    int count = 0;
+    int penalty = lb->pi[first] + lb->pi[last];
+    lb->cities[count++] = first;
+    if (last != first) {
+        lb->cities[count++] = last;
+    }
+    for (int j = 0; j < m; j++) {
+        lb->cities[count++] = cities[j];
+        penalty += 2 * lb->pi[cities[j]];
+    }
+    return spanning_tree(lb, count) - penalty;
+}
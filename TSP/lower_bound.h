@@ -0,0 +1,24 @@
+/* 1-tree and Held-Karp lower bounds on tour length; see lower_bound.c.
+   Needs graph.h first, for graph_t. */
+
+typedef struct {
+    int n;
+    graph_t *g;
+    int *pi;          /* Lagrangian penalty of each city */
+    int iterations;   /* Subgradient steps held_karp_bound() took */
+    /* Scratch, indexed by position in cities[] */
+    int *cities;
+    int *pic;         /* pi[cities[j]] */
+    int *key;
+    int *parent;
+    int *done;
+    int *degree;
+    int *row;         /* Costs out of one city of a sparse graph */
+} lower_bound_t;
+
+extern lower_bound_t *create_lower_bound(graph_t *g);
+extern void free_lower_bound(lower_bound_t *lb);
+extern int one_tree_bound(lower_bound_t *lb);
+extern int held_karp_bound(lower_bound_t *lb, int upper, int max_iterations);
+extern int path_bound(lower_bound_t *lb, int *cities, int m, int first, int last);
+extern const char *prim_step_name;
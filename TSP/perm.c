@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "perm.h"
+
+/**** Permutation ****************/
+
+/* Permutation algorithms based on code found at:
+   http://www.mathblog.dk/project-euler-24-millionth-lexicographic-permutation/
+   which references:
+   http://www.cut-the-knot.org/do_you_know/AllPerm.shtml
+*/
+
+/* Calculate n! iteratively */
+long factorial(int n) {
+    if (n < 1) {
+        return 0;
+    }
+
+    long rtn = 1;
+    for (int i = 1; i <= n; i++) {
+        rtn *= i;
+    }
+    return rtn;
+}
+
+/* n! for n in [0 .. MAX_PERM_SIZE]; the largest that fits in 64 bits. */
+static const uint64_t factorials[MAX_PERM_SIZE + 1] = {
+    1ULL, 1ULL, 2ULL, 6ULL, 24ULL, 120ULL, 720ULL, 5040ULL, 40320ULL,
+    362880ULL, 3628800ULL, 39916800ULL, 479001600ULL, 6227020800ULL,
+    87178291200ULL, 1307674368000ULL, 20922789888000ULL,
+    355687428096000ULL, 6402373705728000ULL, 121645100408832000ULL,
+    2432902008176640000ULL
+};
+
+/* Position of the j-th (from 0) set bit of mask, by binary search on
+   popcounts: six steps whatever the width. */
+static int select_bit(uint64_t mask, int j) {
+    int pos = 0;
+    for (int width = 32; width > 0; width >>= 1) {
+        int below = __builtin_popcountll(mask & ((1ULL << width) - 1));
+        if (j >= below) {
+            j -= below;
+            mask >>= width;
+            pos += width;
+        }
+    }
+    return pos;
+}
+
+/* Write the rank-th (from 0) lexographically ordered permutation of
+   [0 .. size - 1] into perm. The unused values are a bitmask, so each digit
+   of the factorial number system costs a select rather than a list shift.
+   Requires size <= MAX_PERM_SIZE and rank < size!.
+ */
+void perm_unrank(uint64_t rank, int size, int *perm) {
+    uint64_t unused = (1ULL << size) - 1;
+    for (int i = 0; i < size; i++) {
+        uint64_t f = factorials[size - 1 - i];
+        int digit = (int)(rank / f);
+        rank %= f;
+        int value = select_bit(unused, digit);
+        perm[i] = value;
+        unused &= ~(1ULL << value);
+    }
+}
+
+/* Return the 0-based lexographic rank of perm among all orderings of its
+   size values, which must be distinct and below 64 (they need not be
+   0 .. size - 1). This is the inverse of perm_unrank().
+ */
+uint64_t perm_rank(int *perm, int size) {
+    uint64_t later = 0;
+    for (int i = 0; i < size; i++) {
+        later |= 1ULL << perm[i];
+    }
+
+    uint64_t rank = 0;
+    for (int i = 0; i < size; i++) {
+        later &= ~(1ULL << perm[i]);
+        int smaller = __builtin_popcountll(later & ((1ULL << perm[i]) - 1));
+        rank = rank * (size - i) + smaller;
+    }
+    return rank;
+}
+
+/* Return the kth lexographically ordered permuation of an array of k integers
+   in the range [0 .. size - 1], k counting from 1. The integers are allocated
+   dynamically and should be free'd by the caller when no longer needed; use
+   perm_unrank() to fill a buffer of your own instead.
+*/
+int *kth_perm(uint64_t k, int size) {
+    int *rtn = (int *)malloc(size * sizeof(int));
+    perm_unrank(k - 1, size, rtn);
+    return rtn;
+}
+
+/* Swap v[i] and v[j] */
+void swap(int *v, int i, int j) {
+    int t = v[i];
+    v[i] = v[j];
+    v[j] = t;
+}
+
+/* Print a permutation array */
+void print_perm(int *perm, int size) {
+    for (int k = 0; k < size; k++) {
+        printf("%4d", perm[k]);
+    }
+    printf("\n");
+}
+
+/* Given an array of size elements at perm, update the array in place to
+   contain the lexographically next permutation. It is originally due to
+   Dijkstra. The present version is discussed at:
+   http://www.cut-the-knot.org/do_you_know/AllPerm.shtml
+   Returns the pivot: the lowest index whose value changed. Everything before
+   it is untouched, which lets tour costs be updated incrementally.
+ */
+int next_perm(int *perm, int size) {
+    int i = size - 1;
+    while (perm[i - 1] >= perm[i]) {
+        i = i - 1;
+    }
+
+    int j = size;
+    while (perm[j - 1] <= perm[i - 1]) {
+        j = j - 1;
+    }
+
+    swap(perm, i - 1, j - 1);
+    int pivot = i - 1;
+
+    i++;
+    j = size;
+    while (i < j) {
+        swap(perm, i - 1, j - 1);
+        i++;
+        j--;
+    }
+    return pivot;
+}
+
+/* Heap's algorithm, iteratively. Each step of the enumeration is a single
+   swap; this returns its indices through a and b rather than performing it,
+   so the caller can price the swap before making it. The counters c[] must
+   hold size zeros before the first call. Returns 0 once all size!
+   permutations have been visited.
+   https://en.wikipedia.org/wiki/Heap%27s_algorithm
+ */
+int heap_next_swap(int *c, int size, int *a, int *b) {
+    int i = 1;
+    while (i < size) {
+        if (c[i] < i) {
+            *a = (i % 2 == 0) ? 0 : c[i];
+            *b = i;
+            c[i]++;
+            return 1;
+        }
+        c[i] = 0;
+        i++;
+    }
+    return 0;
+}
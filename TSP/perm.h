@@ -0,0 +1,14 @@
+/* Permutation helpers shared by the CPU TSP programs; see perm.c. */
+#include <stdint.h>
+
+/* Largest size whose permutations can all be ranked in 64 bits. */
+#define MAX_PERM_SIZE 20
+
+extern long factorial(int n);
+extern void perm_unrank(uint64_t rank, int size, int *perm);
+extern uint64_t perm_rank(int *perm, int size);
+extern int *kth_perm(uint64_t k, int size);
+extern int next_perm(int *perm, int size);
+extern void swap(int *v, int i, int j);
+extern void print_perm(int *perm, int size);
+extern int heap_next_swap(int *c, int size, int *a, int *b);
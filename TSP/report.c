@@ -0,0 +1,152 @@
+/**
+ * Reporting of improving tours without stalling the search.
+ *
+ * Printing every tour at least as short as the best so far costs a printf
+ * per city, which on instances with many ties is slower than the search.
+ * Instead report_tour() copies the tour into a ring buffer allocated up
+ * front, and the printing happens elsewhere:
+ *
+ *   REPORT_BACKGROUND  a thread drains the ring every few milliseconds.
+ *                      The ring has one writer and one reader, so the two
+ *                      indices are enough to share it without a lock. If
+ *                      the printer falls behind, tours are dropped and
+ *                      counted rather than waiting for it.
+ *   REPORT_AFTER       nothing is printed until report_stop(); the ring
+ *                      keeps the latest tours, overwriting the oldest.
+ *   REPORT_QUIET       nothing is recorded at all.
+ *   REPORT_NOW         the old behaviour: print from the search loop.
+ *
+ * The search keeps its own best tour and tie count either way.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "report.h"
+
+typedef struct {
+    int length;
+    long trial;
+} entry_t;
+
+static report_mode_t mode = REPORT_NOW;
+static int num_cities;
+static int capacity;
+static entry_t *entries;
+static int *tours;               /* capacity tours of num_cities each */
+static atomic_long head;         /* Next slot to write; writer only */
+static atomic_long tail;         /* Next slot to print; reader only */
+static long dropped;             /* Tours not printed */
+static atomic_int running;
+static pthread_t printer;
+
+static const char *mode_names[] = { "now", "background", "after", "quiet" };
+
+/* Look up a mode by name. Returns 0 if there is no such mode. */
+int report_mode_named(const char *name, report_mode_t *m) {
+    for (int i = 0; i < (int)(sizeof(mode_names) / sizeof(mode_names[0])); i++) {
+        if (strcmp(name, mode_names[i]) == 0) {
+            *m = (report_mode_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void print_entry(int *perm, int length, long trial) {
+    for (int j = 0; j < num_cities; j++) {
+        printf("%2d ", perm[j]);
+    }
+    printf(" - len %4d - trial %12ld\n", length, trial);
+}
+
+/* Print the slots from tail up to head. */
+static void drain(void) {
+    long h = atomic_load_explicit(&head, memory_order_acquire);
+    long t = atomic_load_explicit(&tail, memory_order_relaxed);
+    for (; t < h; t++) {
+        int slot = (int)(t % capacity);
+        print_entry(tours + (long)slot * num_cities, entries[slot].length, entries[slot].trial);
+    }
+    atomic_store_explicit(&tail, t, memory_order_release);
+}
+
+static void *print_loop(void *unused) {
+    (void)unused;
+    struct timespec nap = { 0, 5000000 };
+    while (atomic_load(&running)) {
+        drain();
+        fflush(stdout);
+        nanosleep(&nap, NULL);
+    }
+    return NULL;
+}
+
+/* Set up reporting of tours of n cities, holding at most 'capacity'
+   waiting to be printed. */
+void report_start(report_mode_t m, int n, int cap) {
+    mode = m;
+    num_cities = n;
+    capacity = (cap > 0) ? cap : 1;
+    atomic_store(&head, 0);
+    atomic_store(&tail, 0);
+    dropped = 0;
+    if (mode == REPORT_NOW || mode == REPORT_QUIET) {
+        return;
+    }
+
+    entries = malloc(capacity * sizeof(entry_t));
+    tours = malloc((long)capacity * n * sizeof(int));
+    if (mode == REPORT_BACKGROUND) {
+        atomic_store(&running, 1);
+        pthread_create(&printer, NULL, print_loop, NULL);
+    }
+}
+
+/* Note a tour at least as short as any before it. */
+void report_tour(int *perm, int length, long trial) {
+    if (mode == REPORT_QUIET) {
+        return;
+    }
+    if (mode == REPORT_NOW) {
+        print_entry(perm, length, trial);
+        return;
+    }
+
+    long h = atomic_load_explicit(&head, memory_order_relaxed);
+    if (h - atomic_load_explicit(&tail, memory_order_acquire) == capacity) {
+        dropped++;
+        if (mode == REPORT_BACKGROUND) {
+            return;
+        }
+        /* Nobody else reads the ring until the end; drop the oldest. */
+        atomic_store_explicit(&tail, h - capacity + 1, memory_order_relaxed);
+    }
+    int slot = (int)(h % capacity);
+    entries[slot].length = length;
+    entries[slot].trial = trial;
+    memcpy(tours + (long)slot * num_cities, perm, num_cities * sizeof(int));
+    atomic_store_explicit(&head, h + 1, memory_order_release);
+}
+
+/* Print whatever is still waiting and release the ring. */
+void report_stop(void) {
+    if (mode == REPORT_NOW || mode == REPORT_QUIET) {
+        return;
+    }
+    if (mode == REPORT_BACKGROUND) {
+        atomic_store(&running, 0);
+        pthread_join(printer, NULL);
+    }
+    if (dropped > 0 && mode == REPORT_AFTER) {
+        printf("(%ld earlier tours not shown)\n", dropped);
+    }
+    drain();
+    if (dropped > 0 && mode == REPORT_BACKGROUND) {
+        printf("(%ld tours not shown; the printer fell behind)\n", dropped);
+    }
+    free(entries);
+    free(tours);
+}
@@ -0,0 +1,13 @@
+/* Deferred printing of improving tours; see report.c. */
+
+typedef enum {
+    REPORT_NOW,          /* Print each tour as it is found */
+    REPORT_BACKGROUND,   /* Queue tours for a printing thread */
+    REPORT_AFTER,        /* Keep the latest tours and print them at the end */
+    REPORT_QUIET         /* Print nothing */
+} report_mode_t;
+
+extern int report_mode_named(const char *name, report_mode_t *mode);
+extern void report_start(report_mode_t mode, int n, int capacity);
+extern void report_tour(int *perm, int length, long trial);
+extern void report_stop(void);
@@ -0,0 +1,45 @@
+/**
+ * xoshiro256** (Blackman and Vigna), a small fast generator with 256 bits
+ * of state. Unlike random(), each caller owns its state, so threads neither
+ * share nor serialize on it, and a run is reproducible from its seeds.
+ */
+#include "rng.h"
+
+/* splitmix64: spreads a seed over the whole state. */
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/* Seed a generator. Different streams of one seed are independent. */
+void rng_seed(rng_t *rng, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ splitmix64(&stream);
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&x);
+    }
+}
+
+uint64_t rng_next(rng_t *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/* Uniform integer in [0 .. bound - 1] (Lemire's multiply-shift). */
+int rng_below(rng_t *rng, int bound) {
+    return (int)(((rng_next(rng) >> 32) * (uint64_t)bound) >> 32);
+}
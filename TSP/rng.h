@@ -0,0 +1,14 @@
+/* Per-thread random numbers; see rng.c. */
+#ifndef RNG_H
+#define RNG_H
+#include <stdint.h>
+
+/* xoshiro256** state. Each thread owns one, so no locking is needed. */
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+extern void rng_seed(rng_t *rng, uint64_t seed, uint64_t stream);
+extern uint64_t rng_next(rng_t *rng);
+extern int rng_below(rng_t *rng, int bound);
+#endif
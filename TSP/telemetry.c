@@ -0,0 +1,132 @@
+/**
+ * Telemetry for the TSP solvers.
+ *
+ * Each thread counts tours, pruned nodes and best-tour updates in its own
+ * counters_t, and every TELEMETRY_SAMPLE_MASK + 1 tours times one step of
+ * generation and one of evaluation, scaled up to estimate where the time
+ * goes. A sampler thread wakes every 'period' seconds, reads all the
+ * counters without stopping anyone, and writes one line: to stderr as
+ * text if dest is "-", else as JSON lines (one line per thread and one
+ * total per sample) to the file dest. The last sample, written by
+ * telemetry_stop(), is the final tally.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry.h"
+
+static counters_t *counters;
+static int num_counters;
+static FILE *out;
+static int json;
+static double sample_period;
+static long start_ns;
+static long last_ns;
+static long last_tours;
+static atomic_int running;
+static pthread_t sampler;
+
+/* Write one sample of every counter. */
+static void sample(int final) {
+    long t = telemetry_ns();
+    double elapsed = (t - start_ns) / 1e9;
+    double since = (t - last_ns) / 1e9;
+    long tours = 0, pruned = 0, updates = 0, eval_ns = 0, gen_ns = 0;
+
+    for (int i = 0; i < num_counters; i++) {
+        counters_t *c = &counters[i];
+        long ct = atomic_load_explicit(&c->tours, memory_order_relaxed);
+        long cp = atomic_load_explicit(&c->pruned, memory_order_relaxed);
+        long cu = atomic_load_explicit(&c->best_updates, memory_order_relaxed);
+        long ce = atomic_load_explicit(&c->eval_ns, memory_order_relaxed);
+        long cg = atomic_load_explicit(&c->gen_ns, memory_order_relaxed);
+        if (json) {
+            fprintf(out, "{\"t\":%.3f,\"thread\":%d,\"tours\":%ld,\"pruned\":%ld,"
+                    "\"best_updates\":%ld,\"eval_s\":%.6f,\"gen_s\":%.6f}\n",
+                    elapsed, i, ct, cp, cu, ce / 1e9, cg / 1e9);
+        }
+        else if (final && num_counters > 1) {
+            fprintf(stderr, "[%8.3fs] thread %3d: %12ld tours (%.3g/s) %10ld pruned %6ld updates\n",
+                    elapsed, i, ct, elapsed > 0 ? ct / elapsed : 0.0, cp, cu);
+        }
+        tours += ct;
+        pruned += cp;
+        updates += cu;
+        eval_ns += ce;
+        gen_ns += cg;
+    }
+
+    double rate = since > 0 ? (tours - last_tours) / since : 0.0;
+    double timed = (double)eval_ns + gen_ns;
+    if (json) {
+        fprintf(out, "{\"t\":%.3f,\"thread\":\"all\",\"tours\":%ld,\"tours_per_sec\":%.0f,"
+                "\"pruned\":%ld,\"best_updates\":%ld,\"eval_s\":%.6f,\"gen_s\":%.6f,\"final\":%s}\n",
+                elapsed, tours, final ? (elapsed > 0 ? tours / elapsed : 0.0) : rate,
+                pruned, updates, eval_ns / 1e9, gen_ns / 1e9, final ? "true" : "false");
+        fflush(out);
+    }
+    else {
+        fprintf(stderr, "[%8.3fs] %s%14ld tours (%.3g/s) %12ld pruned %6ld updates",
+                elapsed, final ? "total " : "      ", tours,
+                final ? (elapsed > 0 ? tours / elapsed : 0.0) : rate, pruned, updates);
+        if (timed > 0) {
+            fprintf(stderr, " - eval %.0f%% gen %.0f%%", 100.0 * eval_ns / timed, 100.0 * gen_ns / timed);
+        }
+        fprintf(stderr, "\n");
+    }
+    last_ns = t;
+    last_tours = tours;
+}
+
+static void *sample_loop(void *unused) {
+    (void)unused;
+    struct timespec nap = { 0, 10000000 };   /* Check for a stop every 10ms */
+    long next = start_ns + (long)(sample_period * 1e9);
+    while (atomic_load(&running)) {
+        nanosleep(&nap, NULL);
+        if (telemetry_ns() >= next) {
+            sample(0);
+            next += (long)(sample_period * 1e9);
+        }
+    }
+    return NULL;
+}
+
+/* Allocate zeroed counters for num_threads threads and, if dest is not
+   NULL, start sampling them every 'period' seconds. The counters are
+   returned even when telemetry is off, so callers need not check. */
+counters_t *telemetry_start(int num_threads, char *dest, double period) {
+    counters = aligned_alloc(64, num_threads * sizeof(counters_t));
+    memset(counters, 0, num_threads * sizeof(counters_t));
+    num_counters = num_threads;
+    out = NULL;
+    start_ns = last_ns = telemetry_ns();
+    last_tours = 0;
+    if (dest == NULL) {
+        return counters;
+    }
+
+    json = strcmp(dest, "-") != 0;
+    out = json ? fopen(dest, "w") : stderr;
+    if (out == NULL) {
+        perror(dest);
+        exit(1);
+    }
+    sample_period = period > 0 ? period : 1.0;
+    atomic_store(&running, 1);
+    pthread_create(&sampler, NULL, sample_loop, NULL);
+    return counters;
+}
+
+/* Stop sampling and write the final tally. */
+void telemetry_stop(void) {
+    if (out != NULL) {
+        atomic_store(&running, 0);
+        pthread_join(sampler, NULL);
+        sample(1);
+        if (json) {
+            fclose(out);
+        }
+    }
+    free(counters);
+}
@@ -0,0 +1,34 @@
+/* Hot-path counters and periodic throughput reports; see telemetry.c. */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* One timing sample per TELEMETRY_SAMPLE_MASK + 1 tours. */
+#define TELEMETRY_SAMPLE_MASK 1023
+
+/* One thread's counters, written only by that thread. Each sits on its own
+   cache line so threads never share one. */
+typedef struct {
+    _Atomic long tours;          /* Tours evaluated */
+    _Atomic long pruned;         /* Search nodes cut off by a bound */
+    _Atomic long best_updates;   /* Times this thread's best improved */
+    _Atomic long eval_ns;        /* Estimated time scoring tours */
+    _Atomic long gen_ns;         /* Estimated time generating tours */
+} __attribute__((aligned(64))) counters_t;
+
+/* The owner bumps its counters with a plain load and store: no lock and no
+   read-modify-write, but still safe for the sampler to read. */
+#define COUNTER_ADD(c, field, k)                                              \
+    atomic_store_explicit(&(c)->field,                                        \
+        atomic_load_explicit(&(c)->field, memory_order_relaxed) + (k),        \
+        memory_order_relaxed)
+
+static inline long telemetry_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+extern counters_t *telemetry_start(int num_threads, char *dest, double period);
+extern void telemetry_stop(void);
@@ -0,0 +1,376 @@
+/**
+ * Benchmark driver for the TSP engines.
+ *
+ * Runs each engine over every combination of the city counts (-c), seeds
+ * (-s) and thread counts (-n) given as comma separated lists, -r times
+ * each, and reports per combination the median and the 10th and 90th
+ * percentiles of the wall time and of the tours per second. Wall time is
+ * taken here, around the whole run; the tours come from the engine's own
+ * "Trials" or "Checked" line, and its shortest tour from the "Shortest" or
+ * "Lowest tour" line, so a run that disagrees with the others shows up.
+ * Results go to stdout as a table and, with -o and -j, to a CSV or JSON
+ * file for tracking across releases.
+ *
+ * Engines are commands run through the shell, with %c, %s and %n replaced
+ * by the city count, seed and thread count. The built-in ones (-e, by
+ * name) expect the binaries in the directory given with -d; -x adds one
+ * given as name=command.
+ *
+ * Build: gcc -std=gnu99 -O2 -o tsp-bench tsp-bench.c tsp.c -lm
+ * Run:   ./tsp-bench -e serial,threads,omp -c 9,10,11 -s 1,2 -n 1,2,4 -r 5 -o bench.csv
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+
+#define MAX_ENGINES 16
+#define MAX_GRID 32
+#define MAX_RUNS 1000
+
+typedef struct {
+    const char *name;
+    const char *command;
+    int threaded;        /* Uses the thread count; else run once per grid point */
+} engine_t;
+
+/* Built-in engines; %d is the binary directory. */
+static const engine_t builtin[] = {
+    { "serial", "%d/tsp-serial -g lex -q -c %c -s %s", 0 },
+    { "serial-bnb", "%d/tsp-serial -b -q -c %c -s %s", 0 },
+    { "threads", "%d/tsp-threads -c %c -s %s -n %n", 1 },
+    { "threads-batch", "%d/tsp-threads -b -c %c -s %s -n %n", 1 },
+    { "omp", "%d/tsp-omp -c %c -s %s -n 1024 -t %n", 1 },
+    { "mpi", "mpirun --oversubscribe -np %N %d/tsp-mpi -c %c -s %s", 1 },
+    { "held-karp", "%d/held-karp -c %c -s %s -n %n", 1 },
+    { "gpu", "%d/GPU/g_tsp -c %c -s %s -n 1024", 0 },
+};
+
+/* One run of an engine. */
+typedef struct {
+    double wall;         /* Seconds */
+    long tours;          /* -1 if the engine did not say */
+    int shortest;        /* INT_MAX if the engine did not say */
+    int ok;              /* Exited with status 0 */
+} run_t;
+
+engine_t engines[MAX_ENGINES];
+int num_engines = 0;
+int cities[MAX_GRID];
+int num_cities = 0;
+int seeds[MAX_GRID];
+int num_seeds = 0;
+int threads[MAX_GRID];
+int num_thread_counts = 0;
+int repeats = 5;
+char *bin_dir = ".";
+
+/* Parse a comma separated list of ints into list[]; returns the count. */
+int parse_list(char *s, int *list) {
+    int count = 0;
+    for (char *tok = strtok(s, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        if (count == MAX_GRID) {
+            fprintf(stderr, "At most %d values per list\n", MAX_GRID);
+            exit(1);
+        }
+        list[count++] = atoi(tok);
+    }
+    return count;
+}
+
+void add_engine(const char *name, const char *command, int threaded) {
+    if (num_engines == MAX_ENGINES) {
+        fprintf(stderr, "At most %d engines\n", MAX_ENGINES);
+        exit(1);
+    }
+    engines[num_engines].name = name;
+    engines[num_engines].command = command;
+    engines[num_engines].threaded = threaded;
+    num_engines++;
+}
+
+/* Expand an engine's command template. %N is the thread count plus one,
+   for MPI's master rank. */
+void expand(const char *fmt, int c, int s, int n, char *out, size_t len) {
+    size_t k = 0;
+    for (const char *p = fmt; *p != '\0' && k + 32 < len; p++) {
+        if (*p != '%' || p[1] == '\0') {
+            out[k++] = *p;
+            continue;
+        }
+        switch (*++p) {
+        case 'c':
+            k += sprintf(out + k, "%d", c);
+            break;
+        case 's':
+            k += sprintf(out + k, "%d", s);
+            break;
+        case 'n':
+            k += sprintf(out + k, "%d", n);
+            break;
+        case 'N':
+            k += sprintf(out + k, "%d", n + 1);
+            break;
+        case 'd':
+            k += snprintf(out + k, len - k - 32, "%s", bin_dir);
+            break;
+        default:
+            out[k++] = '%';
+            out[k++] = *p;
+        }
+    }
+    out[k] = '\0';
+}
+
+/* Run a command once, timing it and picking the tours and shortest tour
+   out of what it prints. */
+run_t run_once(const char *command) {
+    run_t r = { 0.0, -1, INT_MAX, 0 };
+    char line[4096];
+    double start_time = now();
+    FILE *out = popen(command, "r");
+    if (out == NULL) {
+        perror(command);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), out) != NULL) {
+        long tours;
+        int length;
+        if (sscanf(line, "Trials %ld", &tours) == 1 || sscanf(line, "Checked %ld tours", &tours) == 1) {
+            r.tours = tours;
+        }
+        if (sscanf(line, "Shortest %d", &length) == 1 || sscanf(line, "Lowest tour %d", &length) == 1) {
+            r.shortest = length;
+        }
+    }
+    r.ok = (pclose(out) == 0);
+    r.wall = now() - start_time;
+    return r;
+}
+
+static int by_value(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* p-th percentile of the sorted v[0 .. count - 1], interpolating between
+   the nearest ranks. */
+double percentile(double *v, int count, double p) {
+    double at = p / 100.0 * (count - 1);
+    int lo = (int)at;
+    int hi = (lo + 1 < count) ? lo + 1 : lo;
+    return v[lo] + (at - lo) * (v[hi] - v[lo]);
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -e <engines, comma separated:");
+    for (size_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++) {
+        fprintf(stderr, " %s", builtin[i].name);
+    }
+    fprintf(stderr, ">\n");
+    fprintf(stderr, "   -x <name=command: another engine; %%c, %%s, %%n become cities, seed, threads>\n");
+    fprintf(stderr, "   -d <directory of the engine binaries>\n");
+    fprintf(stderr, "   -c <city counts, comma separated>\n");
+    fprintf(stderr, "   -s <random seeds, comma separated>\n");
+    fprintf(stderr, "   -n <thread counts, comma separated>\n");
+    fprintf(stderr, "   -r <runs of each combination>\n");
+    fprintf(stderr, "   -o <CSV file>\n");
+    fprintf(stderr, "   -j <JSON file>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *csv_name = NULL;
+    char *json_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:d:e:hj:n:o:r:s:x:")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = parse_list(optarg, cities);
+            break;
+        case 'd':
+            bin_dir = optarg;
+            break;
+        case 'e':
+            for (char *tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                size_t i = 0;
+                while (i < sizeof(builtin) / sizeof(builtin[0]) && strcmp(builtin[i].name, tok) != 0) {
+                    i++;
+                }
+                if (i == sizeof(builtin) / sizeof(builtin[0])) {
+                    fprintf(stderr, "No engine called %s\n", tok);
+                    usage(argv[0]);
+                }
+                add_engine(builtin[i].name, builtin[i].command, builtin[i].threaded);
+            }
+            break;
+        case 'j':
+            json_name = optarg;
+            break;
+        case 'n':
+            num_thread_counts = parse_list(optarg, threads);
+            break;
+        case 'o':
+            csv_name = optarg;
+            break;
+        case 'r':
+            repeats = atoi(optarg);
+            break;
+        case 's':
+            num_seeds = parse_list(optarg, seeds);
+            break;
+        case 'x': {
+            char *eq = strchr(optarg, '=');
+            if (eq == NULL) {
+                usage(argv[0]);
+            }
+            *eq = '\0';
+            add_engine(optarg, eq + 1, strstr(eq + 1, "%n") != NULL);
+            break;
+        }
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (num_engines == 0) {
+        add_engine(builtin[0].name, builtin[0].command, builtin[0].threaded);
+    }
+    if (num_cities == 0) {
+        cities[num_cities++] = 10;
+    }
+    if (num_seeds == 0) {
+        seeds[num_seeds++] = 42;
+    }
+    if (num_thread_counts == 0) {
+        threads[num_thread_counts++] = 1;
+    }
+    if (repeats < 1 || repeats > MAX_RUNS) {
+        fprintf(stderr, "Runs must be in [1 .. %d]\n", MAX_RUNS);
+        exit(1);
+    }
+
+    FILE *csv = NULL;
+    FILE *json = NULL;
+    if (csv_name != NULL && (csv = fopen(csv_name, "w")) == NULL) {
+        perror(csv_name);
+        exit(1);
+    }
+    if (json_name != NULL && (json = fopen(json_name, "w")) == NULL) {
+        perror(json_name);
+        exit(1);
+    }
+    if (csv != NULL) {
+        fprintf(csv, "engine,cities,seed,threads,runs,failed,shortest,tours,"
+                "wall_p10,wall_median,wall_p90,tps_p10,tps_median,tps_p90\n");
+    }
+    if (json != NULL) {
+        fprintf(json, "[\n");
+    }
+    printf("%-14s %6s %6s %7s %9s %12s %10s %10s %10s %14s\n", "engine", "cities", "seed",
+           "threads", "shortest", "tours", "wall p10", "median", "p90", "tours/s median");
+
+    int first_record = 1;
+    char command[4096];
+    double wall[MAX_RUNS];
+    double rate[MAX_RUNS];
+    for (int e = 0; e < num_engines; e++) {
+        engine_t *eng = &engines[e];
+        for (int ci = 0; ci < num_cities; ci++) {
+            for (int si = 0; si < num_seeds; si++) {
+                for (int ti = 0; ti < (eng->threaded ? num_thread_counts : 1); ti++) {
+                    int c = cities[ci];
+                    int s = seeds[si];
+                    int n = eng->threaded ? threads[ti] : 1;
+                    expand(eng->command, c, s, n, command, sizeof(command));
+                    strcat(command, " 2>/dev/null");
+
+                    int failed = 0;
+                    int ok_runs = 0;
+                    int shortest = INT_MAX;
+                    long tours = -1;
+                    for (int r = 0; r < repeats; r++) {
+                        run_t run = run_once(command);
+                        if (!run.ok) {
+                            failed++;
+                            continue;
+                        }
+                        if (ok_runs > 0 && run.shortest != shortest) {
+                            fprintf(stderr, "%s: shortest %d, earlier runs %d\n", command, run.shortest, shortest);
+                        }
+                        shortest = run.shortest;
+                        tours = run.tours;
+                        wall[ok_runs] = run.wall;
+                        rate[ok_runs] = (run.tours >= 0 && run.wall > 0) ? run.tours / run.wall : 0.0;
+                        ok_runs++;
+                    }
+                    if (ok_runs == 0) {
+                        fprintf(stderr, "%s: every run failed\n", command);
+                        continue;
+                    }
+                    qsort(wall, ok_runs, sizeof(double), by_value);
+                    qsort(rate, ok_runs, sizeof(double), by_value);
+                    double w10 = percentile(wall, ok_runs, 10);
+                    double w50 = percentile(wall, ok_runs, 50);
+                    double w90 = percentile(wall, ok_runs, 90);
+                    double r10 = percentile(rate, ok_runs, 10);
+                    double r50 = percentile(rate, ok_runs, 50);
+                    double r90 = percentile(rate, ok_runs, 90);
+
+                    /* Engines that do not count tours get no rate: empty in
+                       the CSV, null in the JSON. */
+                    char rates[3][32];
+                    for (int k = 0; k < 3; k++) {
+                        double v = (k == 0) ? r10 : (k == 1) ? r50 : r90;
+                        if (tours >= 0) {
+                            sprintf(rates[k], "%.0f", v);
+                        }
+                        else {
+                            rates[k][0] = '\0';
+                        }
+                    }
+                    printf("%-14s %6d %6d %7d %9d %12ld %10.4f %10.4f %10.4f %14s\n", eng->name, c, s, n,
+                           shortest == INT_MAX ? -1 : shortest, tours, w10, w50, w90,
+                           tours >= 0 ? rates[1] : "-");
+                    fflush(stdout);
+                    if (csv != NULL) {
+                        fprintf(csv, "%s,%d,%d,%d,%d,%d,%d,%ld,%.6f,%.6f,%.6f,%s,%s,%s\n",
+                                eng->name, c, s, n, ok_runs, failed,
+                                shortest == INT_MAX ? -1 : shortest, tours,
+                                w10, w50, w90, rates[0], rates[1], rates[2]);
+                    }
+                    if (json != NULL) {
+                        fprintf(json, "%s  {\"engine\": \"%s\", \"cities\": %d, \"seed\": %d, \"threads\": %d, "
+                                "\"runs\": %d, \"failed\": %d, \"shortest\": %d, \"tours\": %ld, "
+                                "\"wall\": {\"p10\": %.6f, \"median\": %.6f, \"p90\": %.6f}, ",
+                                first_record ? "" : ",\n", eng->name, c, s, n, ok_runs, failed,
+                                shortest == INT_MAX ? -1 : shortest, tours, w10, w50, w90);
+                        if (tours >= 0) {
+                            fprintf(json, "\"tours_per_sec\": {\"p10\": %s, \"median\": %s, \"p90\": %s}}",
+                                    rates[0], rates[1], rates[2]);
+                        }
+                        else {
+                            fprintf(json, "\"tours_per_sec\": null}");
+                        }
+                        first_record = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    if (json != NULL) {
+        fprintf(json, "\n]\n");
+        fclose(json);
+    }
+    return 0;
+}
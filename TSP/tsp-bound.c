@@ -0,0 +1,113 @@
+/**
+ * Gap report: how far a heuristic tour can be from optimal.
+ *
+ * Builds a tour by nearest neighbour and 2-opt/Or-opt local search, bounds
+ * the optimum from below by the Held-Karp 1-tree bound (see lower_bound.c)
+ * and prints the gap between the two. The optimum lies somewhere in it.
+ *
+ * Build: gcc -std=gnu99 -O2 tsp-bound.c lower_bound.c local_search.c graph.c rng.c tsp.c perm.c tsp_file.c -lm
+ * Run:   ./a.out -f att48.tsp
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "tsp.h"
+#include "tsp_file.h"
+#include "graph.h"
+#include "local_search.h"
+#include "lower_bound.h"
+
+int num_cities = 100;
+int random_seed = 42;
+int num_neighbours = 10;
+int max_iterations = 200;
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB, binary or DIMACS; overrides -c and -s>\n");
+    fprintf(stderr, "   -k <neighbours per city>\n");
+    fprintf(stderr, "   -i <subgradient iterations>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *tsp_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:hi:k:s:")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'i':
+            max_iterations = atoi(optarg);
+            break;
+        case 'k':
+            num_neighbours = atoi(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    graph_t *graph;
+    if (tsp_file_name != NULL) {
+        graph = load_graph(tsp_file_name, 1);
+        num_cities = graph->n;
+    }
+    else if (num_cities >= 2) {
+        graph = dense_graph(create_tsp(num_cities, random_seed), num_cities);
+    }
+    if (num_cities < 2 || num_neighbours < 1 || max_iterations < 1) {
+        fprintf(stderr, "Need at least 2 cities, 1 neighbour and 1 iteration, exiting...\n");
+        exit(1);
+    }
+    if (!graph->symmetric) {
+        fprintf(stderr, "Lower bounds need a symmetric instance\n");
+        exit(1);
+    }
+    if (num_neighbours > num_cities - 1) {
+        num_neighbours = num_cities - 1;
+    }
+
+    /* Upper bound: a good tour. */
+    double start_time = now();
+    int *tour = malloc(num_cities * sizeof(int));
+    int *neighbours = neighbour_lists(graph, num_neighbours);
+    long num_moves = 0;
+    nearest_neighbour_tour(graph, 0, tour);
+    int upper = local_search(graph, neighbours, num_neighbours, tour,
+                             &num_moves, NULL, NULL);
+    double tour_time = now() - start_time;
+
+    /* Lower bound. */
+    start_time = now();
+    lower_bound_t *lb = create_lower_bound(graph);
+    int plain = one_tree_bound(lb);
+    int lower = held_karp_bound(lb, upper, max_iterations);
+    double bound_time = now() - start_time;
+
+    /* Report. */
+    printf("Cities %d\n", num_cities);
+    printf("Tour %d (%5.3f seconds)\n", upper, tour_time);
+    printf("1-tree bound %d\n", plain);
+    printf("Held-Karp bound %d (%d iterations, %s Prim, %5.3f seconds)\n",
+           lower, lb->iterations, prim_step_name, bound_time);
+    printf("Gap %.2f%%\n", upper > 0 ? 100.0 * (upper - lower) / upper : 0.0);
+
+    free_lower_bound(lb);
+    free(neighbours);
+    free(tour);
+    free_graph(graph);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * Write a TSP instance as a binary distance matrix (see tsp_file.c), from a
+ * TSPLIB file or from the same seeded random instance the solvers build.
+ *
+ * Build: gcc -std=gnu99 -O2 -o tsp-convert tsp-convert.c tsp.c perm.c tsp_file.c -lm
+ * Run:   ./tsp-convert -f att48.tsp -o att48.bin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "tsp.h"
+#include "tsp_file.h"
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags] -o <output file>\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int num_cities = 5;
+    int random_seed = 42;
+    char *tsp_file_name = NULL;
+    char *out_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:ho:s:")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'o':
+            out_file_name = optarg;
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (out_file_name == NULL || num_cities < 1) {
+        usage(argv[0]);
+    }
+
+    int *distances;
+    if (tsp_file_name != NULL) {
+        distances = load_tsp(tsp_file_name, &num_cities);
+    }
+    else {
+        distances = create_tsp(num_cities, random_seed);
+    }
+    write_tsp_binary(distances, num_cities, out_file_name);
+
+    tsp_file_t *f = tsp_open(out_file_name);
+    printf("%s: %d cities, %d byte distances\n", out_file_name, f->n, f->elt_size);
+    tsp_close(f);
+    free(distances);
+    return 0;
+}
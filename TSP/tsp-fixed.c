@@ -0,0 +1,115 @@
+/**
+ * Benchmark of the size-specialized lexicographic walks in fixed_size.c
+ * against the generic one.
+ *
+ * For each city count in [-a .. -b], walks the same tours with both
+ * versions, checks they agree and prints tours/second for each and the
+ * speedup. At most -t tours are walked per size, so the large sizes finish,
+ * and the fastest of -r runs counts, to keep other load out of the numbers.
+ *
+ * Build: gcc -std=gnu99 -O2 tsp-fixed.c fixed_size.c tsp.c perm.c -lm
+ * Run:   ./a.out -a 8 -b 16 -t 50000000
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "fixed_size.h"
+
+int random_seed = 42;
+int min_cities = FIXED_MIN;
+int max_cities = FIXED_MAX;
+long max_tours = 20000000;
+int canonical = 0;
+int repeats = 3;
+
+/* Walk and time it, best of 'repeats' runs; returns tours scored per
+   second, which under -u is only the canonical ranks of the 'count'. */
+double time_walk(lex_walk_t lex_walk, int *tsp, int n, long count, int *best, walk_t *w) {
+    double fastest = 0.0;
+    for (int r = 0; r < repeats; r++) {
+        double start_time = now();
+        lex_walk(tsp, n, canonical, 0, count, best, w);
+        double elapsed = now() - start_time;
+        if (r == 0 || elapsed < fastest) {
+            fastest = elapsed;
+        }
+    }
+    return fastest > 0 ? w->num_trials / fastest : 0.0;
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -a <smallest number of cities>\n");
+    fprintf(stderr, "   -b <largest number of cities>\n");
+    fprintf(stderr, "   -t <most tours per size>\n");
+    fprintf(stderr, "   -r <runs per walk; the fastest counts>\n");
+    fprintf(stderr, "   -u (unique tours only: fix city 0, skip reflections)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int ch;
+    while ((ch = getopt(argc, argv, "a:b:hr:s:t:u")) != -1) {
+        switch (ch) {
+        case 'a':
+            min_cities = atoi(optarg);
+            break;
+        case 'b':
+            max_cities = atoi(optarg);
+            break;
+        case 'r':
+            repeats = atoi(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 't':
+            max_tours = atol(optarg);
+            break;
+        case 'u':
+            canonical = 1;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (min_cities < 3 || max_cities > MAX_PERM_SIZE || min_cities > max_cities || max_tours < 1 ||
+        repeats < 1) {
+        fprintf(stderr, "Need 3 <= smallest <= largest <= %d and at least 1 tour and run\n", MAX_PERM_SIZE);
+        exit(1);
+    }
+
+    printf("%6s %12s %14s %14s %8s\n", "cities", "tours", "generic/s", "fixed/s", "speedup");
+    for (int n = min_cities; n <= max_cities; n++) {
+        int *tsp = create_tsp(n, random_seed);
+        long count = factorial(n - canonical);
+        if (count > max_tours) {
+            count = max_tours;
+        }
+        int best_generic[n];
+        int best_fixed[n];
+        walk_t generic;
+        walk_t fixed;
+
+        lex_walk_t lex_walk = select_lex_walk(n);
+        double generic_rate = time_walk(lex_walk_generic, tsp, n, count, best_generic, &generic);
+        double fixed_rate = time_walk(lex_walk, tsp, n, count, best_fixed, &fixed);
+        if (generic.shortest != fixed.shortest || generic.num_as_short != fixed.num_as_short ||
+            generic.num_trials != fixed.num_trials ||
+            tour_length(best_fixed, n, tsp) != fixed.shortest) {
+            fprintf(stderr, "%d cities: the %s walk disagrees with the generic walk\n", n, lex_walk_name);
+            exit(1);
+        }
+        printf("%6d %12ld %14.0f %14.0f %7.2fx%s\n", n, fixed.num_trials, generic_rate, fixed_rate,
+               generic_rate > 0 ? fixed_rate / generic_rate : 0.0,
+               lex_walk == lex_walk_generic ? " (no fixed walk)" : "");
+        free(tsp);
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * Dense against sparse (CSR) distances: memory and lookup speed.
+ *
+ * Builds a road-like one-way graph (see graph.c): city i has an arc to
+ * i + 1, so a tour exists, and -k more to random cities within -w of it,
+ * each with its own cost in either direction. Or reads a DIMACS graph with
+ * -f. Then reports the memory each form takes and the time per lookup for
+ * the arcs of the graph and for random pairs of cities, most of which are
+ * missing. -o writes the generated graph as a DIMACS file for the
+ * solvers' -f flag.
+ *
+ * Build: gcc -std=gnu99 -O2 tsp-graph.c graph.c rng.c tsp.c perm.c tsp_file.c -lm
+ * Run:   ./a.out -c 10000 -k 4
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "tsp.h"
+#include "tsp_file.h"
+#include "graph.h"
+#include "rng.h"
+
+int num_cities = 5000;
+int num_arcs = 4;        /* Random arcs out of each city */
+int window = 50;         /* How far away (by number) they may go */
+int random_seed = 42;
+long num_lookups = 20000000;
+
+/* Generate the graph described above. */
+tsp_arc_t *road_graph(int n, long *m) {
+    rng_t rng;
+    rng_seed(&rng, random_seed, 0);
+    tsp_arc_t *arcs = malloc((long)n * (num_arcs + 1) * sizeof(tsp_arc_t));
+    long count = 0;
+    for (int i = 0; i < n; i++) {
+        tsp_arc_t next = { i, (i + 1) % n, 1 + (int)rng_below(&rng, 100) };
+        arcs[count++] = next;
+        for (int a = 0; a < num_arcs; a++) {
+            int to = (int)((i + 1 + rng_below(&rng, window)) % n);
+            tsp_arc_t arc = { i, to, 1 + (int)rng_below(&rng, 100) };
+            arcs[count++] = arc;
+        }
+    }
+    *m = count;
+    return arcs;
+}
+
+void write_dimacs(tsp_arc_t *arcs, int n, long m, char *file_name) {
+    FILE *fp = fopen(file_name, "w");
+    if (fp == NULL) {
+        perror(file_name);
+        exit(1);
+    }
+    fprintf(fp, "c road-like graph, seed %d\np sp %d %ld\n", random_seed, n, m);
+    for (long k = 0; k < m; k++) {
+        fprintf(fp, "a %d %d %d\n", arcs[k].from + 1, arcs[k].to + 1, arcs[k].cost);
+    }
+    fclose(fp);
+}
+
+/* Look up every pair of from[] and to[]; returns nanoseconds per lookup.
+   The sum is returned through *sum so it can be compared and is not
+   optimized away. */
+double time_lookups(graph_t *g, int *from, int *to, long count, long *sum) {
+    double start_time = now();
+    long total = 0;
+    for (long k = 0; k < count; k++) {
+        total += graph_dist(g, from[k], to[k]);
+    }
+    double elapsed = now() - start_time;
+    *sum = total;
+    return elapsed * 1e9 / count;
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -k <random arcs per city>\n");
+    fprintf(stderr, "   -w <window the arcs fall in>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <DIMACS graph file; overrides -c, -k, -w and -s>\n");
+    fprintf(stderr, "   -o <write the generated graph to this DIMACS file>\n");
+    fprintf(stderr, "   -l <number of lookups>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *graph_file_name = NULL;
+    char *out_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:hk:l:o:s:w:")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            graph_file_name = optarg;
+            break;
+        case 'k':
+            num_arcs = atoi(optarg);
+            break;
+        case 'l':
+            num_lookups = atol(optarg);
+            break;
+        case 'o':
+            out_file_name = optarg;
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (num_cities < 2 || num_arcs < 0 || window < 1 || num_lookups < 1) {
+        fprintf(stderr, "Need at least 2 cities, a window of 1 and 1 lookup, exiting...\n");
+        exit(1);
+    }
+
+    long m;
+    tsp_arc_t *arcs;
+    if (graph_file_name != NULL) {
+        arcs = read_dimacs(graph_file_name, &num_cities, &m);
+        if (arcs == NULL) {
+            fprintf(stderr, "%s is not a DIMACS graph\n", graph_file_name);
+            exit(1);
+        }
+    }
+    else {
+        arcs = road_graph(num_cities, &m);
+    }
+    if (out_file_name != NULL) {
+        write_dimacs(arcs, num_cities, m, out_file_name);
+    }
+    int n = num_cities;
+
+    /* Lookups: arcs of the graph in random order, then random pairs. */
+    rng_t rng;
+    rng_seed(&rng, random_seed, 1);
+    int *from = malloc(2 * num_lookups * sizeof(int));
+    int *to = malloc(2 * num_lookups * sizeof(int));
+    for (long k = 0; k < num_lookups; k++) {
+        tsp_arc_t *a = &arcs[rng_below(&rng, (int)m)];
+        from[k] = a->from;
+        to[k] = a->to;
+        from[num_lookups + k] = (int)rng_below(&rng, n);
+        to[num_lookups + k] = (int)rng_below(&rng, n);
+    }
+
+    double start_time = now();
+    graph_t *sparse = sparse_graph(arcs, n, m);
+    double sparse_build = now() - start_time;
+    start_time = now();
+    graph_t *dense = dense_graph(graph_to_dense(sparse), n);
+    double dense_build = now() - start_time;
+
+    long sums[4];
+    double sparse_arc = time_lookups(sparse, from, to, num_lookups, &sums[0]);
+    double dense_arc = time_lookups(dense, from, to, num_lookups, &sums[1]);
+    double sparse_any = time_lookups(sparse, from + num_lookups, to + num_lookups, num_lookups, &sums[2]);
+    double dense_any = time_lookups(dense, from + num_lookups, to + num_lookups, num_lookups, &sums[3]);
+    if (sums[0] != sums[1] || sums[2] != sums[3]) {
+        fprintf(stderr, "Sparse and dense lookups disagree\n");
+        exit(1);
+    }
+
+    printf("Cities %d, arcs %ld (%s)\n", n, sparse->row_start[n],
+           sparse->symmetric ? "symmetric" : "asymmetric");
+    printf("%-8s %14s %10s %14s %14s\n", "form", "bytes", "build s", "ns/arc", "ns/any pair");
+    printf("%-8s %14zu %10.3f %14.2f %14.2f\n", "dense", graph_bytes(dense), dense_build, dense_arc, dense_any);
+    printf("%-8s %14zu %10.3f %14.2f %14.2f\n", "sparse", graph_bytes(sparse), sparse_build, sparse_arc, sparse_any);
+    printf("Sparse takes %.2f%% of the dense memory\n", 100.0 * graph_bytes(sparse) / graph_bytes(dense));
+
+    free_graph(sparse);
+    free_graph(dense);
+    free(from);
+    free(to);
+    free(arcs);
+    return 0;
+}
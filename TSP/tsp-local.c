@@ -0,0 +1,187 @@
+/**
+ * Heuristic TSP: nearest neighbour tour improved by 2-opt and Or-opt local
+ * search (see local_search.c). Scales to thousands of cities, but gives no
+ * guarantee of optimality; -e checks the result against an exhaustive
+ * search on small instances.
+ *
+ * Build: gcc -std=gnu99 -O2 tsp-local.c local_search.c graph.c rng.c tsp.c perm.c tsp_file.c -lm
+ * Run:   ./a.out -c 2000 -s 42 -v
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+#include "graph.h"
+#include "local_search.h"
+
+/* Largest instance -e will enumerate. */
+#define MAX_EXACT 12
+
+int num_cities = 1000;
+int random_seed = 42;
+int num_neighbours = 10;
+
+/* Improvement curve, printed as it goes with -v. */
+typedef struct {
+    double start_time;
+    double last_time;
+    int verbose;
+} curve_t;
+
+/* Print a point of the improvement curve, at most one per millisecond. */
+void record_improvement(int length, void *arg) {
+    curve_t *curve = arg;
+    if (curve->verbose) {
+        double t = now();
+        if (t - curve->last_time >= 0.001) {
+            printf("%10.6f %d\n", t - curve->start_time, length);
+            curve->last_time = t;
+        }
+    }
+}
+
+/* Shortest tour by trying every one that starts at city 0. */
+int exact_tour(int *tsp, int n, int *tour) {
+    int perm[n];
+    int prefix[n];
+    int shortest = INT_MAX;
+    int pivot = 0;
+    long count = factorial(n - 1);
+
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    for (long k = 0; k < count; k++) {
+        if (k > 0) {
+            pivot = 1 + next_perm(perm + 1, n - 1);
+        }
+        int total = tour_length_from(perm, n, tsp, prefix, pivot);
+        if (total < shortest) {
+            shortest = total;
+            for (int i = 0; i < n; i++) {
+                tour[i] = perm[i];
+            }
+        }
+    }
+    return shortest;
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB, binary or DIMACS; overrides -c and -s>\n");
+    fprintf(stderr, "   -k <neighbours per city>\n");
+    fprintf(stderr, "   -e (compare with the exact solution; at most %d cities)\n", MAX_EXACT);
+    fprintf(stderr, "   -v (print the improvement curve: seconds, tour length)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *tsp_file_name = NULL;
+    int exact = 0;
+    curve_t curve = { 0.0, 0.0, 0 };
+    int ch;
+    while ((ch = getopt(argc, argv, "c:ef:hk:s:v")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'e':
+            exact = 1;
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'k':
+            num_neighbours = atoi(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 'v':
+            curve.verbose = 1;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    graph_t *graph;
+    if (tsp_file_name != NULL) {
+        graph = load_graph(tsp_file_name, 1);
+        num_cities = graph->n;
+    }
+    else if (num_cities >= 2) {
+        graph = dense_graph(create_tsp(num_cities, random_seed), num_cities);
+    }
+    if (num_cities < 2 || num_neighbours < 1) {
+        fprintf(stderr, "Need at least 2 cities and 1 neighbour, exiting...\n");
+        exit(1);
+    }
+    if (!graph->symmetric) {
+        fprintf(stderr, "Local search needs a symmetric instance\n");
+        exit(1);
+    }
+    if (exact && num_cities > MAX_EXACT) {
+        fprintf(stderr, "Exact comparison needs at most %d cities\n", MAX_EXACT);
+        exit(1);
+    }
+    if (num_neighbours > num_cities - 1) {
+        num_neighbours = num_cities - 1;
+    }
+
+    int *tour = malloc(num_cities * sizeof(int));
+    double start_time = now();
+    int *neighbours = neighbour_lists(graph, num_neighbours);
+    int initial = nearest_neighbour_tour(graph, 0, tour);
+    double build_time = now() - start_time;
+
+    long num_moves = 0;
+    curve.start_time = now();
+    curve.last_time = 0.0;
+    if (curve.verbose) {
+        printf("%10.6f %d\n", 0.0, initial);
+    }
+    int length = local_search(graph, neighbours, num_neighbours, tour,
+                              &num_moves, record_improvement, &curve);
+    double search_time = now() - curve.start_time;
+    if (curve.verbose) {
+        printf("%10.6f %d\n", search_time, length);
+    }
+
+    /* Report. */
+    printf("\n");
+    if (num_cities <= 30) {
+        print_perm(tour, num_cities);
+    }
+    printf("Cities %d, %d neighbours each\n", num_cities, num_neighbours);
+    printf("Nearest neighbour %d (%.3f seconds with neighbour lists)\n", initial, build_time);
+    printf("Local search %d - %.2f%% shorter - %ld moves\n", length,
+           initial > 0 ? 100.0 * (initial - length) / initial : 0.0, num_moves);
+    printf("Improvement %d in %5.3f seconds (%.0f per second)\n", initial - length,
+           search_time, search_time > 0 ? (initial - length) / search_time : 0.0);
+    if (graph_tour_length(graph, tour) != length) {
+        fprintf(stderr, "Tour length does not match the local search\n");
+    }
+
+    if (exact) {
+        int best[num_cities];
+        int *distances = graph_to_dense(graph);
+        int shortest = exact_tour(distances, num_cities, best);
+        free(distances);
+        printf("Optimal %d - local search is %.2f%% above\n", shortest,
+               shortest > 0 ? 100.0 * (length - shortest) / shortest : 0.0);
+    }
+
+    free(neighbours);
+    free(tour);
+    free_graph(graph);
+    return 0;
+}
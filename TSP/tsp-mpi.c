@@ -0,0 +1,353 @@
+/**
+ * MPI-distributed TSP search.
+ *
+ * Rank 0 is the master: it splits the tour ranks [1 .. n!] into ranges and
+ * hands the next one to whichever worker asks, so there is no static split.
+ * Workers walk each range with next_perm() and prune: once the path through
+ * perm[0 .. i] plus the cheapest edge out of every city still to visit is
+ * longer than the best known tour, every permutation sharing that prefix is
+ * skipped at once. Each request carries the worker's best length and each
+ * reply the best length seen anywhere, so the bound tightens on every rank
+ * as the search goes.
+ *
+ * Build: mpicc -std=gnu99 -O2 tsp-mpi.c tsp.c perm.c tsp_file.c -lm
+ * Run:   mpirun -np 8 ./a.out -c 12 -s 42
+ */
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+
+#define MASTER_CORE 0
+#define REQUEST_TAG 1
+#define TASK_TAG 2
+
+/* Per-rank results, gathered on the master at the end. */
+typedef struct {
+    long num_trials;     /* Tours evaluated */
+    long num_pruned;     /* Prefixes cut off by the bound */
+    long num_tasks;      /* Ranges handed to this rank */
+    double busy;         /* Seconds spent searching */
+    int best;            /* Shortest tour this rank found */
+    int num_as_short;    /* Tours this rank found of length best */
+} mystery_box_t;
+
+int num_cities = 5;
+int tasks_per_worker = 64;
+int random_seed = 42;
+int canonical = 0;       /* Fix city 0 first and skip reflected tours */
+
+int *distances;
+int *min_out;
+int min_out_total;
+
+/* Put the values of v[from .. n - 1] in descending order, making it the
+   lexicographically last arrangement of that suffix. */
+void sort_descending(int *v, int from, int n) {
+    for (int i = from + 1; i < n; i++) {
+        int val = v[i];
+        int j = i - 1;
+        while (j >= from && v[j] < val) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = val;
+    }
+}
+
+/* Walk ranks [first .. last]. shortest is the best length known anywhere and
+   is lowered as this rank finds better tours. */
+void run_task(mystery_box_t *my_box, long first, long last, int *shortest, int *best_tour) {
+    int n = num_cities;
+    int fixed = canonical ? 1 : 0;
+    int ranked_cities = n - fixed;
+    int ranked[n];
+    int perm[n];
+    int prefix[n];       /* Path length through perm[i] */
+    int min_prefix[n];   /* Sum of min_out[] through perm[i] */
+    int canon_first = 0;
+    int pivot = 0;
+    int dirty = 0;
+
+    perm_unrank((uint64_t)(first - 1), n - fixed, ranked);
+    perm[0] = 0;
+    for (int i = 0; i < ranked_cities; i++) {
+        perm[i + fixed] = ranked[i] + fixed;
+    }
+
+    for (long rank = first; ; ) {
+        if (!canonical || is_canonical(perm, n, pivot, &canon_first)) {
+            int total = tour_length_from(perm, n, distances, prefix, dirty);
+            for (int i = dirty; i < n; i++) {
+                min_prefix[i] = (i > 0 ? min_prefix[i - 1] : 0) + min_out[perm[i]];
+            }
+            dirty = n;
+
+            /* Find the shortest prefix the bound rules out, if any. Blocks
+               of one permutation are not worth skipping. */
+            int cut = -1;
+            for (int i = (pivot > fixed ? pivot : fixed); i < n - 2; i++) {
+                int bound = prefix[i] + min_out_total - min_prefix[i] + min_out[perm[i]];
+                if (bound > *shortest) {
+                    cut = i;
+                    break;
+                }
+            }
+
+            if (cut >= 0) {
+                /* Jump to the last permutation that shares perm[0 .. cut]. */
+                int tail = n - cut - 1;
+                long skipped = factorial(tail) - 1 - perm_rank(perm + cut + 1, tail);
+                sort_descending(perm, cut + 1, n);
+                dirty = cut + 1;
+                my_box->num_pruned++;
+                rank += skipped;
+                if (rank >= last) {
+                    break;
+                }
+            }
+            else {
+                my_box->num_trials++;
+                if (total <= my_box->best) {
+                    if (total == my_box->best) {
+                        my_box->num_as_short++;
+                    }
+                    else {
+                        my_box->best = total;
+                        my_box->num_as_short = 1;
+                        for (int i = 0; i < n; i++) {
+                            best_tour[i] = perm[i];
+                        }
+                    }
+                    *shortest = (total < *shortest) ? total : *shortest;
+                }
+            }
+        }
+
+        if (rank >= last) {
+            break;
+        }
+        pivot = fixed + next_perm(perm + fixed, ranked_cities);
+        dirty = (pivot < dirty) ? pivot : dirty;
+        rank++;
+    }
+}
+
+/* Hand out ranges until they run out, then tell each worker to stop. */
+void master(int num_procs, long tours) {
+    MPI_Status status;
+    int num_workers = num_procs - 1;
+    long num_tasks = (long)num_workers * tasks_per_worker;
+    if (num_tasks > tours) {
+        num_tasks = tours;
+    }
+    long per_task = tours / num_tasks;
+    long extra = tours % num_tasks;
+    long next_first = 1;
+    long task = 0;
+    int shortest = INT_MAX;
+    int stopped = 0;
+
+    while (stopped < num_workers) {
+        int worker_best;
+        MPI_Recv(&worker_best, 1, MPI_INT, MPI_ANY_SOURCE, REQUEST_TAG, MPI_COMM_WORLD, &status);
+        shortest = (worker_best < shortest) ? worker_best : shortest;
+
+        /* first, last, best known length; first of 0 means stop */
+        long reply[3] = { 0, 0, shortest };
+        if (task < num_tasks) {
+            long count = per_task + (task < extra ? 1 : 0);
+            reply[0] = next_first;
+            reply[1] = next_first + count - 1;
+            next_first += count;
+            task++;
+        }
+        else {
+            stopped++;
+        }
+        MPI_Send(reply, 3, MPI_LONG, status.MPI_SOURCE, TASK_TAG, MPI_COMM_WORLD);
+    }
+}
+
+/* Ask for ranges until the master says stop. */
+void worker(mystery_box_t *my_box, int *best_tour) {
+    MPI_Status status;
+    int shortest = INT_MAX;
+
+    for (;;) {
+        long reply[3];
+        MPI_Send(&shortest, 1, MPI_INT, MASTER_CORE, REQUEST_TAG, MPI_COMM_WORLD);
+        MPI_Recv(reply, 3, MPI_LONG, MASTER_CORE, TASK_TAG, MPI_COMM_WORLD, &status);
+        shortest = (reply[2] < shortest) ? (int)reply[2] : shortest;
+        if (reply[0] == 0) {
+            break;
+        }
+
+        double start_time = now();
+        run_task(my_box, reply[0], reply[1], &shortest, best_tour);
+        my_box->busy += now() - start_time;
+        my_box->num_tasks++;
+    }
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
+    fprintf(stderr, "   -t <tasks per worker>\n");
+    fprintf(stderr, "   -u (unique tours only: fix city 0, skip reflections)\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int num_procs;
+    int rank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    char *tsp_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:hs:t:u")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 't':
+            tasks_per_worker = atoi(optarg);
+            break;
+        case 'u':
+            canonical = 1;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    /* Every rank reads the same file, or builds the same instance from the
+       seed. */
+    if (tsp_file_name != NULL) {
+        distances = load_tsp(tsp_file_name, &num_cities);
+    }
+    else {
+        distances = create_tsp(num_cities, random_seed);
+    }
+    if (num_cities < 3) {
+        canonical = 0;
+    }
+    if (canonical && !is_symmetric(distances, num_cities)) {
+        if (!rank) {
+            fprintf(stderr, "Canonical mode (-u) needs a symmetric instance\n");
+        }
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (num_procs < 2) {
+        fprintf(stderr, "Need a master and at least one worker, exiting...\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (num_cities < 2 || num_cities > MAX_PERM_SIZE + canonical || tasks_per_worker < 1) {
+        if (!rank) {
+            fprintf(stderr, "Number of cities must be in [2 .. %d]\n", MAX_PERM_SIZE + canonical);
+        }
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    min_out = min_out_edges(distances, num_cities);
+    min_out_total = 0;
+    for (int i = 0; i < num_cities; i++) {
+        min_out_total += min_out[i];
+    }
+    if (!rank) {
+        print_tsp(distances, num_cities, random_seed);
+    }
+
+    mystery_box_t my_box = { 0, 0, 0, 0.0, INT_MAX, 0 };
+    int best_tour[num_cities];
+    for (int i = 0; i < num_cities; i++) {
+        best_tour[i] = i;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = now();
+    if (rank == MASTER_CORE) {
+        master(num_procs, factorial(num_cities - canonical));
+    }
+    else {
+        worker(&my_box, best_tour);
+    }
+    double elapsed = now() - start_time;
+
+    /* Gather per-rank results on the master. */
+    mystery_box_t boxes[num_procs];
+    int tours[num_procs * num_cities];
+    MPI_Gather(&my_box, sizeof(mystery_box_t), MPI_BYTE,
+               boxes, sizeof(mystery_box_t), MPI_BYTE, MASTER_CORE, MPI_COMM_WORLD);
+    MPI_Gather(best_tour, num_cities, MPI_INT,
+               tours, num_cities, MPI_INT, MASTER_CORE, MPI_COMM_WORLD);
+
+    if (!rank) {
+        int shortest = INT_MAX;
+        int best_rank = 1;
+        for (int r = 1; r < num_procs; r++) {
+            if (boxes[r].best < shortest) {
+                shortest = boxes[r].best;
+                best_rank = r;
+            }
+        }
+
+        long num_trials = 0;
+        long num_pruned = 0;
+        int num_as_short = 0;
+        double total_busy = 0.0;
+        double max_busy = 0.0;
+        for (int r = 1; r < num_procs; r++) {
+            mystery_box_t *b = &boxes[r];
+            printf("Rank %3d: %4ld tasks, %12ld tours, %10ld pruned, %7.3f s busy, %12.0f tours/sec\n",
+                   r, b->num_tasks, b->num_trials, b->num_pruned, b->busy,
+                   b->busy > 0 ? b->num_trials / b->busy : 0.0);
+            num_trials += b->num_trials;
+            num_pruned += b->num_pruned;
+            if (b->best == shortest) {
+                num_as_short += b->num_as_short;
+            }
+            total_busy += b->busy;
+            max_busy = (b->busy > max_busy) ? b->busy : max_busy;
+        }
+        double mean_busy = total_busy / (num_procs - 1);
+
+        /* Report. Canonical counts are scaled back up to all n! tours. */
+        int scale = canonical ? tour_multiplicity(num_cities) : 1;
+        double num_tours = 1.0;
+        for (int i = 2; i <= num_cities; i++) {
+            num_tours *= i;
+        }
+        printf("\n");
+        print_perm(tours + best_rank * num_cities, num_cities);
+        printf("Trials %ld\n", num_trials);
+        printf("Shortest %d - %d tours - %.6f%%\n", shortest, num_as_short * scale,
+               (float)((double)num_as_short * scale / num_tours * 100.0));
+        printf("Pruned %ld partial tours\n", num_pruned);
+        printf("Load imbalance %.1f%% (max busy %.3f s, mean %.3f s)\n",
+               mean_busy > 0 ? (max_busy / mean_busy - 1.0) * 100.0 : 0.0, max_busy, mean_busy);
+        printf("Program took %5.3f seconds to run on %d ranks.\n", elapsed, num_procs);
+    }
+
+    free(min_out);
+    free(distances);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * Multi-start parallel local search for the TSP.
+ *
+ * Each restart builds a randomized nearest neighbour tour and improves it
+ * with 2-opt and Or-opt (see local_search.c). Restarts are dealt out round
+ * robin to the threads. Restart r draws from its own xoshiro stream seeded
+ * by (seed, r), and ties between equally short tours go to the lower
+ * restart, so the result depends only on the seed and the number of
+ * restarts: the same for any thread count and any scheduling.
+ *
+ * The best tour is published lock free: a thread that beats it fills a new
+ * record and swings the global pointer to it with a compare-and-swap.
+ * Records are never written once published and are freed at the end.
+ *
+ * Build: gcc -std=gnu11 -O2 -pthread tsp-multistart.c local_search.c graph.c rng.c tsp.c perm.c tsp_file.c -lm
+ * Run:   ./a.out -c 2000 -n 8 -r 64
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+#include "graph.h"
+#include "local_search.h"
+
+/* A published best tour. */
+typedef struct best {
+    int length;
+    int restart;         /* Restart that found it */
+    int *tour;
+    struct best *next;   /* Older records of the same thread, for freeing */
+} best_t;
+
+/* Per-thread state */
+typedef struct {
+    int id;
+    int num_restarts;    /* Restarts this thread ran */
+    int best;            /* Shortest tour this thread found */
+    long num_moves;      /* Improving moves made */
+    best_t *records;     /* Every record this thread published */
+} mystery_box_t;
+
+int num_cities = 1000;
+int num_threads = 1;
+int num_restarts = 64;
+int num_neighbours = 10;
+int random_seed = 42;
+
+graph_t *graph;
+int *neighbours;
+_Atomic(best_t *) global_best = NULL;
+
+/* Does a beat b? Shorter wins, then the earlier restart. */
+int beats(best_t *a, best_t *b) {
+    return b == NULL || a->length < b->length ||
+           (a->length == b->length && a->restart < b->restart);
+}
+
+/* Publish a tour if it beats the global best. */
+void publish_best(mystery_box_t *my_box, int *tour, int length, int restart) {
+    best_t *current = atomic_load(&global_best);
+    best_t candidate = { length, restart, NULL, NULL };
+    if (!beats(&candidate, current)) {
+        return;
+    }
+
+    best_t *mine = malloc(sizeof(best_t));
+    *mine = candidate;
+    mine->tour = malloc(num_cities * sizeof(int));
+    memcpy(mine->tour, tour, num_cities * sizeof(int));
+    mine->next = my_box->records;
+    while (beats(mine, current)) {
+        if (atomic_compare_exchange_weak(&global_best, &current, mine)) {
+            my_box->records = mine;
+            return;
+        }
+    }
+    free(mine->tour);
+    free(mine);
+}
+
+void *multi_start(void *parameter) {
+    mystery_box_t *my_box = (mystery_box_t *)parameter;
+    int *tour = malloc(num_cities * sizeof(int));
+    rng_t rng;
+
+    for (int r = my_box->id; r < num_restarts; r += num_threads) {
+        rng_seed(&rng, random_seed, r);
+        random_neighbour_tour(graph, neighbours, num_neighbours, &rng, tour);
+        int length = local_search(graph, neighbours, num_neighbours, tour,
+                                  &my_box->num_moves, NULL, NULL);
+        my_box->num_restarts++;
+        if (length < my_box->best) {
+            my_box->best = length;
+        }
+        publish_best(my_box, tour, length, r);
+    }
+    free(tour);
+    return NULL;
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB, binary or DIMACS; overrides -c and -s>\n");
+    fprintf(stderr, "   -n <number of threads>\n");
+    fprintf(stderr, "   -r <number of restarts>\n");
+    fprintf(stderr, "   -k <neighbours per city>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *tsp_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:hk:n:r:s:")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'k':
+            num_neighbours = atoi(optarg);
+            break;
+        case 'n':
+            num_threads = atoi(optarg);
+            break;
+        case 'r':
+            num_restarts = atoi(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (tsp_file_name != NULL) {
+        graph = load_graph(tsp_file_name, 1);
+        num_cities = graph->n;
+    }
+    else if (num_cities >= 2) {
+        graph = dense_graph(create_tsp(num_cities, random_seed), num_cities);
+    }
+    if (num_cities < 2 || num_neighbours < 1) {
+        fprintf(stderr, "Need at least 2 cities and 1 neighbour, exiting...\n");
+        exit(1);
+    }
+    if (!graph->symmetric) {
+        fprintf(stderr, "Local search needs a symmetric instance\n");
+        exit(1);
+    }
+    if (num_threads < 1 || num_restarts < 1) {
+        fprintf(stderr, "Invalid thread or restart count, exiting...\n");
+        exit(1);
+    }
+    if (num_neighbours > num_cities - 1) {
+        num_neighbours = num_cities - 1;
+    }
+
+    double start_time = now();
+    neighbours = neighbour_lists(graph, num_neighbours);
+
+    pthread_t threads[num_threads];
+    mystery_box_t boxes[num_threads];
+    for (int i = 0; i < num_threads; i++) {
+        boxes[i].id = i;
+        boxes[i].num_restarts = 0;
+        boxes[i].best = INT_MAX;
+        boxes[i].num_moves = 0;
+        boxes[i].records = NULL;
+        pthread_create(&threads[i], NULL, multi_start, &boxes[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start_time;
+
+    /* Report. */
+    best_t *best = atomic_load(&global_best);
+    long num_moves = 0;
+    for (int i = 0; i < num_threads; i++) {
+        mystery_box_t *b = &boxes[i];
+        printf("Thread %3d: %4d restarts, best %d, %ld moves\n",
+               b->id, b->num_restarts, b->best, b->num_moves);
+        num_moves += b->num_moves;
+    }
+    printf("\n");
+    if (num_cities <= 30) {
+        print_perm(best->tour, num_cities);
+    }
+    printf("Restarts %d - %ld moves\n", num_restarts, num_moves);
+    printf("Shortest %d - from restart %d\n", best->length, best->restart);
+    if (graph_tour_length(graph, best->tour) != best->length) {
+        fprintf(stderr, "Published tour does not have the published length\n");
+    }
+    printf("Program took %5.3f seconds to run on %d threads (%.1f restarts/second).\n",
+           elapsed, num_threads, num_restarts / elapsed);
+
+    for (int i = 0; i < num_threads; i++) {
+        while (boxes[i].records != NULL) {
+            best_t *next = boxes[i].records->next;
+            free(boxes[i].records->tour);
+            free(boxes[i].records);
+            boxes[i].records = next;
+        }
+    }
+    free(neighbours);
+    free_graph(graph);
+    return 0;
+}
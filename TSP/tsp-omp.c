@@ -0,0 +1,142 @@
+/**
+ * CPU port of GPU/g_tsp.cu, with OpenMP.
+ *
+ * Same decomposition as the CUDA kernel: the n! tours (or (n - 1)! with -u)
+ * are split into -n ranges, one per "GPU thread". Each range is started with
+ * perm_unrank() and walked with next_perm(), re-summing only the suffix after
+ * the pivot, and the lowest length over all ranges is a min-reduction. The
+ * ranges are shared among the OpenMP threads (OMP_NUM_THREADS, or -t), so
+ * the CUDA path can be run and checked on any machine. The "Lowest tour"
+ * line is the one g_tsp.cu prints, so the two can be diffed.
+ *
+ * Each range is walked by the version of the walk in fixed_size.c built for
+ * the instance's city count, if there is one.
+ *
+ * Build: gcc -std=gnu99 -O2 -fopenmp tsp-omp.c fixed_size.c tsp.c perm.c tsp_file.c -lm
+ * Run:   ./a.out -c 12 -s 42 -n 1024
+ */
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+#include "fixed_size.h"
+
+/* Largest tour whose ranks fit in 64 bits (20!), plus the fixed city of
+   canonical mode. */
+#define MAX_CITIES 21
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
+    fprintf(stderr, "   -n <number of threads (ranges, as on the GPU)>\n");
+    fprintf(stderr, "   -t <number of OpenMP threads>\n");
+    fprintf(stderr, "   -u (unique tours only: fix city 0, skip reflections)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int random_seed = 42;
+    int num_cities = 5;
+    int num_threads = 1;
+    int canonical = 0;
+    char *tsp_file_name = NULL;
+    int ch;
+    while ((ch = getopt(argc, argv, "c:f:hn:s:t:u")) != -1) {
+        switch (ch) {
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'n':
+            num_threads = atoi(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 't':
+            omp_set_num_threads(atoi(optarg));
+            break;
+        case 'u':
+            canonical = 1;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    int *distances;
+    if (tsp_file_name != NULL) {
+        distances = load_tsp(tsp_file_name, &num_cities);
+    }
+    else {
+        distances = create_tsp(num_cities, random_seed);
+    }
+    /* Canonical tours need cities 1 and 2 to tell the directions apart. */
+    if (num_cities < 3) {
+        canonical = 0;
+    }
+    if (num_cities < 1 || num_cities - canonical > MAX_CITIES - 1) {
+        fprintf(stderr, "Number of cities must be in [1 .. %d]\n", MAX_CITIES - 1 + canonical);
+        exit(1);
+    }
+    if (canonical && !is_symmetric(distances, num_cities)) {
+        fprintf(stderr, "Canonical mode (-u) needs a symmetric instance\n");
+        exit(1);
+    }
+    if (num_threads < 1) {
+        fprintf(stderr, "Invalid thread count, exiting...\n");
+        exit(1);
+    }
+    long fact = factorial(num_cities - canonical);
+    if ((long)num_threads > fact) {
+        num_threads = (int)fact;
+        fprintf(stderr, "Too many processors to run effectively...\nRefactoring number of threads to be 1:1...\nNow running on %d threads\n", num_threads);
+    }
+
+    /* Range tid is [tid * per_range, (tid + 1) * per_range); the last also
+       takes the leftover tours, as in the kernel. */
+    long per_range = fact / num_threads;
+    lex_walk_t lex_walk = select_lex_walk(num_cities);
+    int lowest = INT_MAX;
+    long checked = 0;
+    double start_time = now();
+    #pragma omp parallel for schedule(dynamic) reduction(min:lowest) reduction(+:checked)
+    for (int tid = 0; tid < num_threads; tid++) {
+        long start = tid * per_range;
+        long end = (tid == num_threads - 1) ? fact : start + per_range;
+        int best[MAX_CITIES];
+        walk_t w;
+        lex_walk(distances, num_cities, canonical, (uint64_t)start, end - start, best, &w);
+        if (w.shortest < lowest) {
+            lowest = w.shortest;
+        }
+        checked += w.num_trials;
+    }
+    double elapsed = now() - start_time;
+    free(distances);
+
+    printf("Lowest tour %d found on seed %d in %5.3f seconds\n", lowest, random_seed, elapsed);
+    /* Under -u only the canonical ranks are scored; each stands for its
+       rotations both ways (tour_multiplicity() in tsp.c). */
+    if (canonical) {
+        printf("Checked %ld tours (canonical; each covers %d tours) on %d threads (%d OpenMP, %s walk, %.0f tours/second)\n",
+               checked, tour_multiplicity(num_cities), num_threads, omp_get_max_threads(),
+               lex_walk_name, checked / elapsed);
+    }
+    else {
+        printf("Checked %ld tours on %d threads (%d OpenMP, %s walk, %.0f tours/second)\n",
+               checked, num_threads, omp_get_max_threads(), lex_walk_name, checked / elapsed);
+    }
+    return 0;
+}
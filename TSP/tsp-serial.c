@@ -2,13 +2,27 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <limits.h>
+#include <string.h>
 #include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+#include "batch_eval.h"
+#include "graph.h"
+#include "local_search.h"
+#include "lower_bound.h"
+#include "checkpoint.h"
+#include "telemetry.h"
+#include "report.h"
 
 /* Original permuation code due to D. Jimenez, UT Austin
  * http://faculty.cse.tamu.edu/djimenez/ut/utsa/cs3343/
  */
 
-/* Requires C99 compiler (gcc: -std=c99) */
+/* Requires C99 compiler (gcc: -std=c99)
+ * Build: gcc -std=gnu11 -O2 -pthread tsp-serial.c tsp.c perm.c batch_eval.c tsp_file.c \
+ *        lower_bound.c local_search.c graph.c rng.c checkpoint.c telemetry.c report.c -lm
+ */
 #define DEBUG 0
 #define debug_printf(fmt, ...)                 \
     do {                                       \
@@ -19,16 +33,26 @@
 /* Action function for each permuation. */
 typedef void (*perm_action_t)(int *v, int n);
 
-/* Reference an element in the TSP distance array. */
-#define TSP_ELT(tsp, n, i, j) *(tsp + (i * n) + j)
-#define ONE_BILLION (double)1000000000.0
+/* Lowest index of the permutation changed since the last call to the
+   action; eval_tsp() only re-sums the tour from there. */
+int dirty_from = 0;
+
+/* Note that v[i] (and possibly later entries) changed. */
+void mark_dirty(int i) {
+    if (i < dirty_from) {
+        dirty_from = i;
+    }
+}
 
+/* In canonical mode city 0 stays first and city 1 must come before city 2,
+   so each cycle is visited once instead of 2n times. */
+int canonical = 0;
+int one_placed = 0;
 
-/* Swap array elements. */
-void swap(int *v, int i, int j) {
-    int t = v[i];
-    v[i] = v[j];
-    v[j] = t;
+/* Tell whether placing city next at the end of a canonical prefix breaks
+   the city 1 before city 2 rule. */
+int reflected(int next) {
+    return canonical && next == 2 && !one_placed;
 }
 
 /* Helper function to compute permutations recursively. */
@@ -44,7 +68,12 @@ void perms(int *v, int n, int i, perm_action_t action) {
         for (j = i; j < n; j++) {
             /* Array with i and j switched */
             swap(v, i, j);
-            perms(v, n, i + 1, action);
+            if (!reflected(v[i])) {
+                mark_dirty(i);
+                one_placed |= (v[i] == 1);
+                perms(v, n, i + 1, action);
+                one_placed &= (v[i] != 1);
+            }
             /* Swap back to the way they were */
             swap(v, i, j);
         }
@@ -53,11 +82,11 @@ void perms(int *v, int n, int i, perm_action_t action) {
 
 /* Generate permutations of the elements i to (n - 1). */
 void permutations(int *v, int n, perm_action_t action) {
-    perms(v, n, 0, action);
+    perms(v, n, canonical ? 1 : 0, action);
 }
 
 /* Trivial action to pass to permutations--print out each one. */
-void print_perm(int *perm, int n, char *msge) {
+void print_tour(int *perm, int n, char *msge) {
     for (int j = 0; j < n; j++) {
         printf("%2d ", perm[j]);
     }
@@ -72,70 +101,84 @@ void nop(int *v, int n) {
 int num_cities = 5;
 int shortest_length = INT_MAX;
 int num_as_short = -1;
-int num_trials = 0;
+long num_trials = 0;
 int random_seed = 42;
+char *tsp_file_name = NULL;  /* Instance file; random instance if NULL */
+int *best_tour = NULL;       /* First tour found of length shortest_length */
+counters_t *counters = NULL; /* Telemetry; sampled from another thread with -m */
 
-/* Create an instance of a symmetric TSP. */
-int *create_tsp(int n) {
-    int *tsp = malloc(n * n * sizeof(int));
+/* Improving tours waiting to be printed; see report.c. */
+#define REPORT_CAPACITY 4096
 
-    srandom(random_seed);
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j <= i; j++) {
-            int val = (int)(random() / (RAND_MAX / 100));
-            TSP_ELT(tsp, n, i, j) = val;
-            TSP_ELT(tsp, n, j, i) = val;
+void record_tour(int *perm, int n, int total);
+
+/* Instance shared by all solvers, its distances at their stored width;
+   created once per program run. */
+tsp_file_t *instance = NULL;
+
+/* Return the instance, loading or creating it on first use. */
+tsp_file_t *get_instance(void) {
+    if (NULL == instance) {
+        if (tsp_file_name != NULL) {
+            instance = tsp_open(tsp_file_name);
+            num_cities = instance->n;
+        }
+        else {
+            instance = tsp_random(num_cities, random_seed);
         }
+        tsp_print(instance, random_seed);
     }
-    return tsp;
+    return instance;
 }
 
-/* Print a TSP distance matrix. */
-void print_tsp(int *tsp, int n) {
-    printf("TSP (%d cities - seed %d)\n    ", n, random_seed);
-    for (int j = 0; j < n; j++) {
-        printf("%3d|", j);
+/* The same distances widened to an int matrix, for the bounds of -b and
+   -l, which take one; the walks read the instance itself. */
+int *distances = NULL;
+
+int *get_distances(void) {
+    if (NULL == distances) {
+        distances = tsp_to_ints(get_instance());
     }
-    printf("\n");
-    for (int i = 0; i < n; i++) {
-        printf("%2d|", i);
-        for (int j = 0; j < n; j++) {
-            printf("%4d", TSP_ELT(tsp, n, i, j));
-        }
-        printf("\n");
+    return distances;
+}
+
+/* The same matrix as a graph, for lower_bound.c and local_search.c. */
+graph_t *graph = NULL;
+
+graph_t *get_graph(void) {
+    if (NULL == graph) {
+        graph = dense_graph(get_distances(), get_instance()->n);
     }
-    printf("\n");
+    return graph;
 }
 
 /* Evaluate a single instance of the TSP. */
 void eval_tsp(int *perm, int n) {
-    /* Initialize the distances array once per program run. */
-    static int *distances = NULL;
-    if (NULL == distances) {
-        distances = create_tsp(num_cities);
-        print_tsp(distances, num_cities);
+    tsp_file_t *tsp = get_instance();
+
+    /* Path length from perm[0] to perm[i]; kept between calls so only the
+       part of the tour after dirty_from needs summing again. */
+    static int *prefix = NULL;
+    if (NULL == prefix) {
+        prefix = malloc(n * sizeof(int));
+        prefix[0] = 0;
     }
 
     /* Calculate the length of the tour for the current permutation. */
-    int total = 0;
-    for (int i = 0; i < n; i++) {
-        int j = (i + 1) % n;
-        int from = perm[i];
-        int to = perm[j];
-        int val = TSP_ELT(distances, n, from, to);
-        debug_printf("tsp[%d, %d] = %d\n", from, to, val);
-        total += val;
-    }
+    int total = tsp_tour_length_from(tsp, perm, prefix, dirty_from > 1 ? dirty_from : 1);
+    dirty_from = n;
+    record_tour(perm, n, total);
+}
 
+/* Gather statistics for a tour of the given length. */
+void record_tour(int *perm, int n, int total) {
 #if DEBUG
-    print_perm(perm, n, "PERM");
+    print_tour(perm, n, "PERM");
 #endif
 
     /* Gather statistics. */
     if (total <= shortest_length) {
-        char buf[80];
-        sprintf(buf, "len %4d - trial %12d", total, num_trials);
-        print_perm(perm, n, buf);
+        report_tour(perm, total, num_trials);
 
         if (total == shortest_length) {
             num_as_short++;
@@ -143,19 +186,286 @@ void eval_tsp(int *perm, int n) {
         else
         {
             num_as_short = 1;
+            if (NULL == best_tour) {
+                best_tour = malloc(n * sizeof(int));
+            }
+            memcpy(best_tour, perm, n * sizeof(int));
+            COUNTER_ADD(counters, best_updates, 1);
         }
         shortest_length = total;
     }
     num_trials++;
+    COUNTER_ADD(counters, tours, 1);
     debug_printf("Total %d\n", total);
 }
 
 
-//get current time
-double now(void) {
-    struct timespec current_time;
-    clock_gettime(CLOCK_REALTIME, &current_time);
-    return current_time.tv_sec + (current_time.tv_nsec / ONE_BILLION);
+/**** Branch and bound ****************/
+
+/* Cheapest edge leaving each city (the diagonal is never part of a tour). */
+int *min_out = NULL;
+long num_pruned = 0;
+
+/* With -l, also prune on the 1-tree bound of the rest of the tour, under
+   the Held-Karp penalties found at the root. */
+int use_one_tree = 0;
+lower_bound_t *one_tree = NULL;
+int root_bound = 0;
+
+/* Extend the partial tour v[0 .. i - 1] depth first. 'cost' is the length of
+   the path through the prefix and 'rest' is the sum of min_out[] over the
+   cities not yet placed. Every remaining edge leaves either the last placed
+   city or an unplaced one, so cost + min_out[last] + rest never exceeds the
+   length of any completion; a prefix whose bound already tops shortest_length
+   is dropped. Ties are kept so num_as_short matches the exhaustive search.
+ */
+void bnb(int *tsp, int *v, int n, int i, int cost, int rest) {
+    if (i == n) {
+        eval_tsp(v, n);
+        return;
+    }
+
+    for (int j = i; j < n; j++) {
+        swap(v, i, j);
+        int next = v[i];
+        if (reflected(next)) {
+            swap(v, i, j);
+            continue;
+        }
+        mark_dirty(i);
+        int next_cost = cost + TSP_ELT(tsp, n, v[i - 1], next);
+        int next_rest = rest - min_out[next];
+        if (next_cost + min_out[next] + next_rest > shortest_length) {
+            num_pruned++;
+            COUNTER_ADD(counters, pruned, 1);
+        }
+        else if (one_tree != NULL && n - i - 1 >= 2 &&
+                 next_cost + path_bound(one_tree, v + i + 1, n - i - 1, v[0], next) > shortest_length) {
+            num_pruned++;
+            COUNTER_ADD(counters, pruned, 1);
+        }
+        else {
+            one_placed |= (next == 1);
+            bnb(tsp, v, n, i + 1, next_cost, next_rest);
+            one_placed &= (next != 1);
+        }
+        swap(v, i, j);
+    }
+}
+
+/* Branch-and-bound search over all tours; reports through eval_tsp(). */
+void branch_and_bound(int *v, int n) {
+    int *tsp = get_distances();
+    min_out = min_out_edges(tsp, n);
+
+    int rest = 0;
+    for (int i = 0; i < n; i++) {
+        rest += min_out[i];
+    }
+    if (use_one_tree) {
+        int tour[n];
+        one_tree = create_lower_bound(get_graph());
+        root_bound = held_karp_bound(one_tree, nearest_neighbour_tour(get_graph(), 0, tour), 1000);
+    }
+
+    /* Place each city first in turn, as perms() does; canonical tours always
+       start from city 0. */
+    for (int j = 0; j < (canonical ? 1 : n); j++) {
+        swap(v, 0, j);
+        mark_dirty(0);
+        bnb(tsp, v, n, 1, 0, rest - min_out[v[0]]);
+        swap(v, 0, j);
+    }
+    free(min_out);
+    if (one_tree != NULL) {
+        free_lower_bound(one_tree);
+    }
+}
+
+/**** Checkpoints ****************/
+
+/* Tours between looks at the clock; a power of two less one. */
+#define CHECKPOINT_MASK ((1L << 20) - 1)
+
+/* With -k, lex_permutations() saves its progress to checkpoint_file every
+   checkpoint_interval seconds; with -r it picks up from there. */
+char *checkpoint_file = NULL;
+int resume = 0;
+double checkpoint_interval = 60.0;
+long resumed_trials = 0;     /* Trials counted before the restart */
+
+/* Save the statistics so far; 'rank' is the next tour to evaluate. */
+void save_checkpoint(int n, long rank) {
+    checkpoint_t cp;
+    cp.num_cities = n;
+    cp.canonical = canonical;
+    cp.instance_hash = hash_tsp(get_instance());
+    cp.next_rank = rank;
+    cp.shortest_length = shortest_length;
+    cp.num_as_short = num_as_short;
+    cp.num_trials = num_trials;
+    for (int i = 0; i < n; i++) {
+        cp.best_tour[i] = (best_tour != NULL) ? best_tour[i] : i;
+    }
+    write_checkpoint(checkpoint_file, &cp);
+}
+
+/* Restore the statistics and the permutation v from checkpoint_file, if
+   there is one. Returns the rank to carry on from. */
+long load_checkpoint(int *v, int n) {
+    checkpoint_t cp;
+    if (!read_checkpoint(checkpoint_file, &cp)) {
+        printf("No checkpoint in %s; starting from the beginning\n", checkpoint_file);
+        return 0;
+    }
+    if (cp.num_cities != n || cp.canonical != canonical ||
+        cp.instance_hash != hash_tsp(get_instance())) {
+        fprintf(stderr, "%s was taken on a different instance or mode\n", checkpoint_file);
+        exit(1);
+    }
+
+    shortest_length = cp.shortest_length;
+    num_as_short = cp.num_as_short;
+    num_trials = cp.num_trials;
+    resumed_trials = num_trials;
+    if (num_trials > 0) {
+        best_tour = malloc(n * sizeof(int));
+        memcpy(best_tour, cp.best_tour, n * sizeof(int));
+    }
+
+    int fixed = canonical ? 1 : 0;
+    long count = (n > fixed) ? factorial(n - fixed) : 1;
+    if ((long)cp.next_rank < count) {
+        int ranked[n];
+        perm_unrank(cp.next_rank, n - fixed, ranked);
+        for (int i = 0; i < n - fixed; i++) {
+            v[i + fixed] = ranked[i] + fixed;
+        }
+    }
+    printf("Resuming from rank %llu of %ld\n", (unsigned long long)cp.next_rank, count);
+    return (long)cp.next_rank;
+}
+
+/**** Iterative generators ****************/
+
+/* Walk the tours in lexicographic order with next_perm(), re-summing only
+   the suffix after each pivot. */
+void lex_permutations(int *v, int n) {
+    tsp_file_t *tsp = get_instance();
+    int prefix[n];
+    int first = 0;
+    /* Canonical tours keep city 0 first and permute the rest. */
+    int fixed = canonical ? 1 : 0;
+    long count = (n > fixed) ? factorial(n - fixed) : 1;
+    int pivot = 0;
+    int dirty = 0;
+    long start = resume ? load_checkpoint(v, n) : 0;
+    double last_save = now();
+
+    for (long k = start; k < count; k++) {
+        /* Time one tour in every TELEMETRY_SAMPLE_MASK + 1. */
+        int timed = (k & TELEMETRY_SAMPLE_MASK) == 0;
+        long t0 = timed ? telemetry_ns() : 0;
+        if (k > start) {
+            pivot = fixed + next_perm(v + fixed, n - fixed);
+            dirty = (pivot < dirty) ? pivot : dirty;
+        }
+        /* Only look at the clock once every CHECKPOINT_MASK + 1 tours. */
+        if ((k & CHECKPOINT_MASK) == 0 && checkpoint_file != NULL &&
+            now() - last_save >= checkpoint_interval) {
+            save_checkpoint(n, k);
+            last_save = now();
+        }
+        if (!canonical || is_canonical(v, n, pivot, &first)) {
+            long t1 = timed ? telemetry_ns() : 0;
+            int total = tsp_tour_length_from(tsp, v, prefix, dirty);
+            if (timed) {
+                long t2 = telemetry_ns();
+                COUNTER_ADD(counters, gen_ns, (t1 - t0) * (TELEMETRY_SAMPLE_MASK + 1));
+                COUNTER_ADD(counters, eval_ns, (t2 - t1) * (TELEMETRY_SAMPLE_MASK + 1));
+            }
+            record_tour(v, n, total);
+            dirty = n;
+        }
+    }
+    if (checkpoint_file != NULL) {
+        save_checkpoint(n, count);
+    }
+}
+
+/* Walk the tours in lexicographic order, but transpose them into blocks and
+   score each block with the vectorized evaluator. */
+void batch_permutations(int *v, int n) {
+    tsp_file_t *tsp = get_instance();
+    batch_eval_t eval_batch = select_batch_eval();
+    int soa[n * BATCH_SIZE];
+    int lengths[BATCH_SIZE];
+    int tour[n];
+    int first = 0;
+    int fixed = canonical ? 1 : 0;
+    long count = (n > fixed) ? factorial(n - fixed) : 1;
+    int pivot = 0;
+    int filled = 0;
+
+    for (long k = 0; k < count; k++) {
+        if (k > 0) {
+            pivot = fixed + next_perm(v + fixed, n - fixed);
+        }
+        if (!canonical || is_canonical(v, n, pivot, &first)) {
+            for (int p = 0; p < n; p++) {
+                soa[p * BATCH_SIZE + filled] = v[p];
+            }
+            filled++;
+        }
+        if (filled == BATCH_SIZE || (k == count - 1 && filled > 0)) {
+            eval_batch(soa, n, filled, tsp, lengths);
+            for (int t = 0; t < filled; t++) {
+                /* Only tours that make the report need transposing back. */
+                if (lengths[t] > shortest_length) {
+                    num_trials++;
+                    COUNTER_ADD(counters, tours, 1);
+                    continue;
+                }
+                for (int p = 0; p < n; p++) {
+                    tour[p] = soa[p * BATCH_SIZE + t];
+                }
+                record_tour(tour, n, lengths[t]);
+            }
+            filled = 0;
+        }
+    }
+}
+
+/* Walk the tours with Heap's algorithm. Each step is a single swap, so the
+   new length is the old one plus the change in the edges it touches. */
+void heap_permutations(int *v, int n) {
+    tsp_file_t *tsp = get_instance();
+    int c[n];
+    int a, b;
+    /* Canonical tours keep city 0 first and permute the rest. */
+    int fixed = canonical ? 1 : 0;
+    /* Positions of cities 1 and 2, for the canonical direction check. */
+    int pos[3] = { 0, 1, 2 };
+
+    memset(c, 0, n * sizeof(int));
+    int total = tsp_tour_length(tsp, v);
+    if (!canonical || n < 3 || pos[1] < pos[2]) {
+        record_tour(v, n, total);
+    }
+    while (heap_next_swap(c, n - fixed, &a, &b)) {
+        a += fixed;
+        b += fixed;
+        total += tsp_tour_swap(tsp, v, a, b);
+        if (v[a] < 3) {
+            pos[v[a]] = a;
+        }
+        if (v[b] < 3) {
+            pos[v[b]] = b;
+        }
+        if (!canonical || n < 3 || pos[1] < pos[2]) {
+            record_tour(v, n, total);
+        }
+    }
 }
 
 void usage(char *prog_name) {
@@ -163,6 +473,18 @@ void usage(char *prog_name) {
     fprintf(stderr, "   -h\n");
     fprintf(stderr, "   -c <number of cities>\n");
     fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
+    fprintf(stderr, "   -b (branch and bound instead of brute force)\n");
+    fprintf(stderr, "   -l (with -b, also prune on the Held-Karp 1-tree bound)\n");
+    fprintf(stderr, "   -g <generator: recursive (default), lex, heap, batch>\n");
+    fprintf(stderr, "   -u (unique tours only: fix city 0, skip reflections)\n");
+    fprintf(stderr, "   -k <checkpoint file> (with -g lex)\n");
+    fprintf(stderr, "   -i <seconds between checkpoints>\n");
+    fprintf(stderr, "   -r (resume from the checkpoint file)\n");
+    fprintf(stderr, "   -m <telemetry: - for text on stderr, else a JSON lines file>\n");
+    fprintf(stderr, "   -p <telemetry sample period in seconds>\n");
+    fprintf(stderr, "   -o <improving tours: background (default), after, now, quiet>\n");
+    fprintf(stderr, "   -q (quiet: same as -o quiet)\n");
     exit(1);
 }
 
@@ -170,36 +492,135 @@ int main(int argc, char **argv) {
     /* Use "random" random seed by default. */
     random_seed = time(NULL);
 
+    int use_bnb = 0;
+    char *generator = "recursive";
+    char *telemetry = NULL;
+    double sample_period = 1.0;
+    report_mode_t report_mode = REPORT_BACKGROUND;
     int ch;
-    while ((ch = getopt(argc, argv, "c:hs:")) != -1) {
+    while ((ch = getopt(argc, argv, "bc:f:g:hi:k:lm:o:p:qrs:u")) != -1) {
         switch (ch) {
+        case 'b':
+            use_bnb = 1;
+            break;
+        case 'i':
+            checkpoint_interval = atof(optarg);
+            break;
+        case 'k':
+            checkpoint_file = optarg;
+            break;
+        case 'l':
+            use_one_tree = 1;
+            break;
+        case 'm':
+            telemetry = optarg;
+            break;
+        case 'o':
+            if (!report_mode_named(optarg, &report_mode)) {
+                usage(argv[0]);
+            }
+            break;
+        case 'p':
+            sample_period = atof(optarg);
+            break;
+        case 'q':
+            report_mode = REPORT_QUIET;
+            break;
+        case 'r':
+            resume = 1;
+            break;
+        case 'g':
+            generator = optarg;
+            break;
         case 'c':
             num_cities = atoi(optarg);
             break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
         case 's':
             random_seed = atoi(optarg);
             break;
+        case 'u':
+            canonical = 1;
+            break;
         case 'h':
         default:
             usage(argv[0]);
         }
     }
+    /* Load the instance now, since a file sets the number of cities. */
+    get_instance();
+    if ((checkpoint_file != NULL || resume) &&
+        (use_bnb || strcmp(generator, "lex") != 0 || checkpoint_file == NULL)) {
+        fprintf(stderr, "Checkpoints need -k <file> and -g lex\n");
+        exit(1);
+    }
+    if ((canonical || use_one_tree) && !tsp_symmetric(instance)) {
+        fprintf(stderr, "-u and -l need a symmetric instance\n");
+        exit(1);
+    }
 
     /* Initialize permutation of cities. */
     int order[num_cities];
     for (int i = 0; i < num_cities; i++) {
         order[i] = i;
     }
+    counters = telemetry_start(1, telemetry, sample_period);
+    report_start(report_mode, num_cities, REPORT_CAPACITY);
     double start_time = now();
     /* "Travel, salesman!" */
-    permutations(order, num_cities, eval_tsp);
+    if (use_bnb) {
+        branch_and_bound(order, num_cities);
+    }
+    else if (strcmp(generator, "recursive") == 0) {
+        permutations(order, num_cities, eval_tsp);
+    }
+    else if (strcmp(generator, "lex") == 0) {
+        lex_permutations(order, num_cities);
+    }
+    else if (strcmp(generator, "heap") == 0) {
+        heap_permutations(order, num_cities);
+    }
+    else if (strcmp(generator, "batch") == 0) {
+        batch_permutations(order, num_cities);
+    }
+    else {
+        usage(argv[0]);
+    }
+    double elapsed = now() - start_time;
+    telemetry_stop();
+    report_stop();
 
     /* Report. */
     printf("\n");
-    printf("Trials %d\n", num_trials);
-    float percent_as_short = (float)num_as_short / (float)num_trials * 100.0;
+    if (resume && best_tour != NULL) {
+        /* Improvements found before the restart were printed back then. */
+        print_tour(best_tour, num_cities, "best");
+    }
+    /* Each canonical tour stands for every rotation and reflection of itself,
+       so scale its counts back up to the full space of n! tours. */
+    int scale = canonical ? tour_multiplicity(num_cities) : 1;
+    if (canonical) {
+        printf("Trials %ld (canonical; each covers %d tours)\n", num_trials, scale);
+    }
+    else {
+        printf("Trials %ld\n", num_trials);
+    }
+    double num_tours = 1.0;
+    for (int i = 2; i <= num_cities; i++) {
+        num_tours *= i;
+    }
+    float percent_as_short = (float)((double)num_as_short * scale / num_tours * 100.0);
     printf("Shortest %d - %d tours - %.6f%%\n",
-           shortest_length, num_as_short, percent_as_short);
-    printf("Program took %5.3f seconds to run.", now() - start_time);
+           shortest_length, num_as_short * scale, percent_as_short);
+    if (use_bnb) {
+        printf("Pruned %ld partial tours\n", num_pruned);
+        if (use_one_tree) {
+            printf("Held-Karp bound %d at the root\n", root_bound);
+        }
+    }
+    printf("Program took %5.3f seconds to run (%.0f tours/second).",
+           elapsed, (num_trials - resumed_trials) / elapsed);
     printf("\n");
 }
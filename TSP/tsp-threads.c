@@ -0,0 +1,456 @@
+/**
+ * Multithreaded exhaustive TSP search.
+ *
+ * The n! tours are split into lexicographic rank ranges; each is started with
+ * perm_unrank() and walked with next_perm(). Ranges are dealt out to a deque
+ * per worker thread. A worker pops from the bottom of its own deque and, once it
+ * runs dry, steals from the top of someone else's, so fast threads pick up
+ * the slack of slow ones.
+ *
+ * With -b, tours are scored a block at a time by the vectorized evaluator in
+ * batch_eval.c instead of one by one.
+ *
+ * With -m, each thread's tour, best-update and timing counters are sampled
+ * every -p seconds (see telemetry.c), to watch the tours/second of each
+ * thread as more are added.
+ *
+ * Build: gcc -std=gnu11 -O2 -pthread tsp-threads.c tsp.c perm.c batch_eval.c tsp_file.c telemetry.c -lm
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+#include "perm.h"
+#include "tsp_file.h"
+#include "batch_eval.h"
+#include "telemetry.h"
+
+
+/* A range of tours, by lexicographic rank in [1 .. n!]. */
+typedef struct {
+    long first;
+    long last;
+} task_t;
+
+/* Work-stealing deque. The owner takes from the bottom, thieves from the
+   top. Tasks are only ever removed, so a plain mutex is cheap enough: it is
+   taken once per task, not once per tour. */
+typedef struct {
+    task_t *tasks;
+    int top;
+    int bottom;
+    pthread_mutex_t lock;
+} deque_t;
+
+/* Per-thread state. The statistics are written for every tour by their
+   owner only, and the deque is locked by thieves too, so each sits on its
+   own cache line, as does each worker: no two threads write one line. */
+typedef struct {
+    int id;
+    int best;            /* Shortest tour this thread has seen */
+    int num_as_short;    /* Tours this thread found of length best */
+    long num_trials;     /* Tours evaluated */
+    int num_steals;      /* Tasks taken from other threads */
+    counters_t *counters;
+    deque_t deque __attribute__((aligned(64)));
+} __attribute__((aligned(64))) worker_t;
+
+int num_cities = 5;
+int num_threads = 1;
+int tasks_per_thread = 32;
+int random_seed = 42;
+int canonical = 0;       /* Fix city 0 first and skip reflected tours */
+batch_eval_t eval_batch = NULL;  /* Set when scoring tours in blocks */
+
+tsp_file_t *instance;    /* Distances at their stored width */
+worker_t *workers;
+
+/* Global best tour. The length is published through an atomic so any thread
+   can read it without a lock; the tour itself is copied under best_lock by
+   whichever thread lowered the length. */
+atomic_int shortest_length = INT_MAX;
+int *best_tour;
+pthread_mutex_t best_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Take a task from the bottom of our own deque. */
+int deque_pop(deque_t *d, task_t *task) {
+    int found = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->top < d->bottom) {
+        *task = d->tasks[--d->bottom];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+/* Take a task from the top of another thread's deque. */
+int deque_steal(deque_t *d, task_t *task) {
+    int found = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->top < d->bottom) {
+        *task = d->tasks[d->top++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+/* Try every other worker once, starting after ourselves. */
+int steal_task(worker_t *me, task_t *task) {
+    for (int i = 1; i < num_threads; i++) {
+        worker_t *victim = &workers[(me->id + i) % num_threads];
+        if (deque_steal(&victim->deque, task)) {
+            me->num_steals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Lower the global best to total if it is still shorter, and record the
+   tour. */
+void publish_best(int *perm, int total) {
+    int current = atomic_load(&shortest_length);
+    while (total < current) {
+        if (atomic_compare_exchange_weak(&shortest_length, &current, total)) {
+            pthread_mutex_lock(&best_lock);
+            /* A shorter tour may have landed while we waited. */
+            if (total == atomic_load(&shortest_length)) {
+                memcpy(best_tour, perm, num_cities * sizeof(int));
+            }
+            pthread_mutex_unlock(&best_lock);
+            return;
+        }
+    }
+}
+
+/* Fold one tour of the given length into this thread's statistics. */
+void record_tour(worker_t *me, int *perm, int total) {
+    if (total <= me->best) {
+        if (total == me->best) {
+            me->num_as_short++;
+        }
+        else {
+            me->best = total;
+            me->num_as_short = 1;
+            publish_best(perm, total);
+            COUNTER_ADD(me->counters, best_updates, 1);
+        }
+    }
+    me->num_trials++;
+    COUNTER_ADD(me->counters, tours, 1);
+}
+
+/* Blocks per timed block; BATCH_SAMPLE * BATCH_SIZE tours apart, like
+   the one-by-one sampling. */
+#define BATCH_SAMPLE ((TELEMETRY_SAMPLE_MASK + 1) / BATCH_SIZE)
+
+/* Score a block of tours held structure-of-arrays and record them. If
+   timed, add the time taken to the thread's evaluation counter. */
+void record_batch(worker_t *me, int *soa, int count, int timed) {
+    int n = num_cities;
+    int lengths[BATCH_SIZE];
+    int tour[n];
+
+    long t0 = timed ? telemetry_ns() : 0;
+    eval_batch(soa, n, count, instance, lengths);
+    if (timed) {
+        COUNTER_ADD(me->counters, eval_ns, (telemetry_ns() - t0) * BATCH_SAMPLE);
+    }
+    for (int t = 0; t < count; t++) {
+        /* Only the rare improvements need the tour itself. */
+        if (lengths[t] < me->best) {
+            for (int p = 0; p < n; p++) {
+                tour[p] = soa[p * BATCH_SIZE + t];
+            }
+        }
+        record_tour(me, tour, lengths[t]);
+    }
+}
+
+/* Evaluate every tour in the task's range. In canonical mode ranks number
+   the orderings of cities 1 .. n - 1, with city 0 fixed in front. */
+void run_task(worker_t *me, task_t *task) {
+    int n = num_cities;
+    int fixed = canonical ? 1 : 0;
+    int ranked[n];
+    int perm[n];
+    int prefix[n];
+    int first = 0;
+    int pivot = 0;
+    int dirty = 0;
+
+    perm_unrank((uint64_t)(task->first - 1), n - fixed, ranked);
+    perm[0] = 0;
+    for (int i = 0; i < n - fixed; i++) {
+        perm[i + fixed] = ranked[i] + fixed;
+    }
+
+    for (long rank = task->first; rank <= task->last; rank++) {
+        /* Time one tour in every TELEMETRY_SAMPLE_MASK + 1. */
+        int timed = (rank & TELEMETRY_SAMPLE_MASK) == 0;
+        long t0 = timed ? telemetry_ns() : 0;
+        if (rank > task->first) {
+            pivot = fixed + next_perm(perm + fixed, n - fixed);
+            dirty = (pivot < dirty) ? pivot : dirty;
+        }
+        if (canonical && !is_canonical(perm, n, pivot, &first)) {
+            continue;
+        }
+        long t1 = timed ? telemetry_ns() : 0;
+        int total = tsp_tour_length_from(instance, perm, prefix, dirty);
+        dirty = n;
+        if (timed) {
+            long t2 = telemetry_ns();
+            COUNTER_ADD(me->counters, gen_ns, (t1 - t0) * (TELEMETRY_SAMPLE_MASK + 1));
+            COUNTER_ADD(me->counters, eval_ns, (t2 - t1) * (TELEMETRY_SAMPLE_MASK + 1));
+        }
+        record_tour(me, perm, total);
+    }
+}
+
+/* Same walk as run_task(), but the tours are transposed into blocks and
+   scored by the batch evaluator. */
+void run_task_batch(worker_t *me, task_t *task) {
+    int n = num_cities;
+    int fixed = canonical ? 1 : 0;
+    int ranked[n];
+    int perm[n];
+    int soa[n * BATCH_SIZE];
+    int count = 0;
+    int first = 0;
+    int pivot = 0;
+    long blocks = 0;
+    long t0 = telemetry_ns();
+
+    perm_unrank((uint64_t)(task->first - 1), n - fixed, ranked);
+    perm[0] = 0;
+    for (int i = 0; i < n - fixed; i++) {
+        perm[i + fixed] = ranked[i] + fixed;
+    }
+
+    for (long rank = task->first; rank <= task->last; rank++) {
+        if (rank > task->first) {
+            pivot = fixed + next_perm(perm + fixed, n - fixed);
+        }
+        if (canonical && !is_canonical(perm, n, pivot, &first)) {
+            continue;
+        }
+        for (int p = 0; p < n; p++) {
+            soa[p * BATCH_SIZE + count] = perm[p];
+        }
+        if (++count == BATCH_SIZE) {
+            /* Time the generation of every BATCH_SAMPLE-th block too. */
+            int timed = (blocks++ % BATCH_SAMPLE) == 0;
+            if (timed) {
+                COUNTER_ADD(me->counters, gen_ns, (telemetry_ns() - t0) * BATCH_SAMPLE);
+            }
+            record_batch(me, soa, count, timed);
+            count = 0;
+            t0 = (blocks % BATCH_SAMPLE) == 0 ? telemetry_ns() : 0;
+        }
+    }
+    if (count > 0) {
+        record_batch(me, soa, count, 0);
+    }
+}
+
+void *worker(void *parameter) {
+    worker_t *me = (worker_t *)parameter;
+    task_t task;
+
+    for (;;) {
+        if (!deque_pop(&me->deque, &task) && !steal_task(me, &task)) {
+            /* No task is ever added after start up, so empty stays empty. */
+            break;
+        }
+        if (eval_batch != NULL) {
+            run_task_batch(me, &task);
+        }
+        else {
+            run_task(me, &task);
+        }
+    }
+    return NULL;
+}
+
+/* Split [1 .. tours] into num_tasks ranges and deal them out in contiguous
+   blocks, so each thread starts on its own stretch of the tour space. */
+void distribute_tasks(long tours, int num_tasks) {
+    long per_task = tours / num_tasks;
+    long extra = tours % num_tasks;
+    long first = 1;
+
+    for (int i = 0; i < num_threads; i++) {
+        workers[i].deque.tasks = malloc(tasks_per_thread * sizeof(task_t));
+        workers[i].deque.top = 0;
+        workers[i].deque.bottom = 0;
+        pthread_mutex_init(&workers[i].deque.lock, NULL);
+    }
+
+    for (int t = 0; t < num_tasks; t++) {
+        long count = per_task + (t < extra ? 1 : 0);
+        deque_t *d = &workers[t / tasks_per_thread].deque;
+        /* Push in reverse so the owner's first pop is its lowest range. */
+        int slot = tasks_per_thread - 1 - (t % tasks_per_thread);
+        d->tasks[slot].first = first;
+        d->tasks[slot].last = first + count - 1;
+        d->bottom++;
+        first += count;
+    }
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -c <number of cities>\n");
+    fprintf(stderr, "   -s <random seed>\n");
+    fprintf(stderr, "   -f <instance file: TSPLIB or binary; overrides -c and -s>\n");
+    fprintf(stderr, "   -n <number of threads>\n");
+    fprintf(stderr, "   -t <tasks per thread>\n");
+    fprintf(stderr, "   -b (score tours in vectorized blocks)\n");
+    fprintf(stderr, "   -u (unique tours only: fix city 0, skip reflections)\n");
+    fprintf(stderr, "   -m <telemetry: - for text on stderr, else a JSON lines file>\n");
+    fprintf(stderr, "   -p <telemetry sample period in seconds>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *tsp_file_name = NULL;
+    char *telemetry = NULL;
+    double sample_period = 1.0;
+    int ch;
+    while ((ch = getopt(argc, argv, "bc:f:hm:n:p:s:t:u")) != -1) {
+        switch (ch) {
+        case 'b':
+            eval_batch = select_batch_eval();
+            break;
+        case 'c':
+            num_cities = atoi(optarg);
+            break;
+        case 'f':
+            tsp_file_name = optarg;
+            break;
+        case 'm':
+            telemetry = optarg;
+            break;
+        case 'n':
+            num_threads = atoi(optarg);
+            break;
+        case 'p':
+            sample_period = atof(optarg);
+            break;
+        case 's':
+            random_seed = atoi(optarg);
+            break;
+        case 't':
+            tasks_per_thread = atoi(optarg);
+            break;
+        case 'u':
+            canonical = 1;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (tsp_file_name != NULL) {
+        instance = tsp_open(tsp_file_name);
+        num_cities = instance->n;
+    }
+    int max_cities = MAX_PERM_SIZE + canonical;
+    if (num_cities < 2 || num_cities > max_cities) {
+        fprintf(stderr, "Number of cities must be in [2 .. %d]\n", max_cities);
+        exit(1);
+    }
+    if (num_threads < 1 || tasks_per_thread < 1) {
+        fprintf(stderr, "Invalid thread or task count, exiting...\n");
+        exit(1);
+    }
+
+    long tours = factorial(num_cities - canonical);
+    if ((long)num_threads * tasks_per_thread > tours) {
+        tasks_per_thread = 1;
+        if (num_threads > tours) {
+            num_threads = (int)tours;
+        }
+    }
+    int num_tasks = num_threads * tasks_per_thread;
+
+    if (instance == NULL) {
+        instance = tsp_random(num_cities, random_seed);
+    }
+    if (canonical && !tsp_symmetric(instance)) {
+        fprintf(stderr, "Canonical mode (-u) needs a symmetric instance\n");
+        exit(1);
+    }
+    tsp_print(instance, random_seed);
+    best_tour = malloc(num_cities * sizeof(int));
+
+    workers = aligned_alloc(64, num_threads * sizeof(worker_t));
+    memset(workers, 0, num_threads * sizeof(worker_t));
+    counters_t *counters = telemetry_start(num_threads, telemetry, sample_period);
+    for (int i = 0; i < num_threads; i++) {
+        workers[i].id = i;
+        workers[i].best = INT_MAX;
+        workers[i].counters = &counters[i];
+    }
+    distribute_tasks(tours, num_tasks);
+
+    pthread_t threads[num_threads];
+    double start_time = now();
+    for (int i = 0; i < num_threads; i++) {
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start_time;
+    telemetry_stop();
+
+    /* Merge per-thread statistics. */
+    int shortest = atomic_load(&shortest_length);
+    long num_trials = 0;
+    int num_as_short = 0;
+    for (int i = 0; i < num_threads; i++) {
+        worker_t *w = &workers[i];
+        printf("Thread %3d: %12ld tours, %4d steals\n", w->id, w->num_trials, w->num_steals);
+        num_trials += w->num_trials;
+        if (w->best == shortest) {
+            num_as_short += w->num_as_short;
+        }
+        free(w->deque.tasks);
+        pthread_mutex_destroy(&w->deque.lock);
+    }
+
+    /* Report. Each canonical tour stands for every rotation and reflection
+       of itself, so scale its counts back up to the full n! tours. */
+    int scale = canonical ? tour_multiplicity(num_cities) : 1;
+    printf("\n");
+    print_perm(best_tour, num_cities);
+    if (canonical) {
+        printf("Trials %ld (canonical; each covers %d tours)\n", num_trials, scale);
+    }
+    else {
+        printf("Trials %ld\n", num_trials);
+    }
+    float percent_as_short = (float)num_as_short / (float)num_trials * 100.0;
+    printf("Shortest %d - %d tours - %.6f%%\n",
+           shortest, num_as_short * scale, percent_as_short);
+    printf("Program took %5.3f seconds to run on %d threads", elapsed, num_threads);
+    if (eval_batch != NULL) {
+        printf(" (%s batches)", batch_eval_name);
+    }
+    printf(".\n");
+
+    free(workers);
+    free(best_tour);
+    tsp_close(instance);
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include "tsp.h"
+
+/* Create an instance of a symmetric TSP. */
+int *create_tsp(int n, int seed) {
+    int *tsp = malloc(n * n * sizeof(int));
+
+    srandom(seed);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            int val = (int)(random() / (RAND_MAX / 100));
+            TSP_ELT(tsp, n, i, j) = val;
+            TSP_ELT(tsp, n, j, i) = val;
+        }
+    }
+    return tsp;
+}
+
+/* Print a TSP distance matrix; '-' marks a missing edge. */
+void print_tsp(int *tsp, int n, int seed) {
+    printf("TSP (%d cities - seed %d)\n    ", n, seed);
+    for (int j = 0; j < n; j++) {
+        printf("%3d|", j);
+    }
+    printf("\n");
+    for (int i = 0; i < n; i++) {
+        printf("%2d|", i);
+        for (int j = 0; j < n; j++) {
+            if (TSP_ELT(tsp, n, i, j) == TSP_MISSING(n)) {
+                printf("   -");
+            }
+            else {
+                printf("%4d", TSP_ELT(tsp, n, i, j));
+            }
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+/* Calculate the length of the tour for a permutation of the n cities. */
+int tour_length(int *perm, int n, int *tsp) {
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        int j = (i + 1) % n;
+        total += TSP_ELT(tsp, n, perm[i], perm[j]);
+    }
+    return total;
+}
+
+/* Return the cheapest edge leaving each city; the diagonal is never part of
+   a tour. Allocated dynamically; the caller frees it. */
+int *min_out_edges(int *tsp, int n) {
+    int *min_out = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        min_out[i] = INT_MAX;
+        for (int j = 0; j < n; j++) {
+            if (i != j && TSP_ELT(tsp, n, i, j) < min_out[i]) {
+                min_out[i] = TSP_ELT(tsp, n, i, j);
+            }
+        }
+    }
+    if (n == 1) {
+        min_out[0] = TSP_ELT(tsp, n, 0, 0);
+    }
+    return min_out;
+}
+
+/* Incremental version of tour_length(). prefix[k] holds the length of the
+   path perm[0] .. perm[k]; entries below 'from' must still be valid for the
+   current perm, e.g. 'from' is the pivot returned by next_perm(). Only the
+   changed suffix is re-summed. Pass from = 0 to fill prefix[] from scratch.
+ */
+int tour_length_from(int *perm, int n, int *tsp, int *prefix, int from) {
+    if (from < 1) {
+        prefix[0] = 0;
+        from = 1;
+    }
+    for (int k = from; k < n; k++) {
+        prefix[k] = prefix[k - 1] + TSP_ELT(tsp, n, perm[k - 1], perm[k]);
+    }
+    return prefix[n - 1] + TSP_ELT(tsp, n, perm[n - 1], perm[0]);
+}
+
+/* Swap perm[a] and perm[b] and return the resulting change in tour length.
+   Only the (at most four) edges touching positions a and b are priced.
+ */
+int tour_swap(int *perm, int n, int *tsp, int a, int b) {
+    if (a > b) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    int delta;
+    if (n < 4) {
+        /* Too few edges for the neighbors to be distinct; just re-sum. */
+        delta = -tour_length(perm, n, tsp);
+        int t = perm[a];
+        perm[a] = perm[b];
+        perm[b] = t;
+        return delta + tour_length(perm, n, tsp);
+    }
+
+    if (a == 0 && b == n - 1) {
+        /* Adjacent around the end of the tour; b comes first. */
+        a = n - 1;
+        b = 0;
+    }
+    int x = perm[a];
+    int y = perm[b];
+    int before = perm[a == 0 ? n - 1 : a - 1];
+    int after = perm[b == n - 1 ? 0 : b + 1];
+
+    if (b == a + 1 || (a == n - 1 && b == 0)) {
+        /* before, x, y, after becomes before, y, x, after */
+        delta = TSP_ELT(tsp, n, before, y) + TSP_ELT(tsp, n, y, x)
+              + TSP_ELT(tsp, n, x, after)
+              - TSP_ELT(tsp, n, before, x) - TSP_ELT(tsp, n, x, y)
+              - TSP_ELT(tsp, n, y, after);
+    }
+    else {
+        int x_next = perm[a + 1];
+        int y_prev = perm[b - 1];
+        delta = TSP_ELT(tsp, n, before, y) + TSP_ELT(tsp, n, y, x_next)
+              + TSP_ELT(tsp, n, y_prev, x) + TSP_ELT(tsp, n, x, after)
+              - TSP_ELT(tsp, n, before, x) - TSP_ELT(tsp, n, x, x_next)
+              - TSP_ELT(tsp, n, y_prev, y) - TSP_ELT(tsp, n, y, after);
+    }
+    perm[a] = y;
+    perm[b] = x;
+    return delta;
+}
+
+/* Number of permutations that trace out the same cycle as a given tour in a
+   symmetric TSP: n rotations times two directions. */
+int tour_multiplicity(int n) {
+    return n < 3 ? n : 2 * n;
+}
+
+/* Tell whether the cost of every edge is the same both ways. Canonical
+   mode, the bounds and local search all rely on it. */
+int is_symmetric(int *tsp, int n) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < i; j++) {
+            if (TSP_ELT(tsp, n, i, j) != TSP_ELT(tsp, n, j, i)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Canonical tours start at city 0 and visit city 1 before city 2, which
+   picks one of the two directions around each cycle. Tells whether perm is
+   canonical, given that nothing before 'pivot' changed since the last call.
+   *first caches the position of whichever of cities 1 and 2 comes first;
+   set it to 0 before the first call.
+ */
+int is_canonical(int *perm, int n, int pivot, int *first) {
+    if (pivot <= *first) {
+        *first = n;
+        for (int k = pivot; k < n; k++) {
+            if (perm[k] == 1 || perm[k] == 2) {
+                *first = k;
+                break;
+            }
+        }
+    }
+    return *first == n || perm[*first] == 1;
+}
+
+//get current time
+double now(void) {
+    struct timespec current_time;
+    clock_gettime(CLOCK_REALTIME, &current_time);
+    return current_time.tv_sec + (current_time.tv_nsec / ONE_BILLION);
+}
@@ -0,0 +1,23 @@
+/* TSP instance helpers shared by the CPU TSP programs; see tsp.c. */
+
+/* Reference an element in the TSP distance array. */
+#define TSP_ELT(tsp, n, i, j) (*((tsp) + ((i) * (n)) + (j)))
+#define ONE_BILLION (double)1000000000.0
+
+/* Cost of an edge missing from a sparse instance: n of them still fit in an
+   int. Real edges may cost at most TSP_MAX_COST(n), so a complete tour of n
+   of them neither overflows nor reaches one missing edge, and a tour
+   through one is longer than any complete tour. */
+#define TSP_MISSING(n) (0x7fffffff / ((n) + 1))
+#define TSP_MAX_COST(n) ((TSP_MISSING(n) - 1) / (n))
+
+extern int *create_tsp(int n, int seed);
+extern void print_tsp(int *tsp, int n, int seed);
+extern int tour_length(int *perm, int n, int *tsp);
+extern int *min_out_edges(int *tsp, int n);
+extern int tour_length_from(int *perm, int n, int *tsp, int *prefix, int from);
+extern int tour_swap(int *perm, int n, int *tsp, int a, int b);
+extern int tour_multiplicity(int n);
+extern int is_symmetric(int *tsp, int n);
+extern int is_canonical(int *perm, int n, int pivot, int *first);
+extern double now(void);
@@ -0,0 +1,52 @@
+/* TSP instance files; see tsp_file.c. */
+#include <stddef.h>
+
+/* A distance matrix read from disk. Distances are stored in the narrowest
+   of 1, 2 or 4 bytes that holds them; binary files are mapped, not copied.
+   The exhaustive solvers score tours straight from it, so a large instance
+   takes a quarter or half the cache of an int matrix. */
+typedef struct {
+    int n;            /* Number of cities */
+    int elt_size;     /* Bytes per distance: 1, 2 or 4 */
+    void *data;       /* n * n distances, row major */
+    void *map;        /* mmap'd file, or NULL if data was malloc'd */
+    size_t map_len;
+} tsp_file_t;
+
+/* Bytes that may be read before data: a 4 byte load that ends at any
+   distance stays in the header of a mapped file, or in this much padding
+   in front of a malloc'd one. See batch_eval.c. */
+#define TSP_DATA_LEAD 4
+
+/* Distance from city i to city j, whatever the width. */
+static inline int tsp_dist(const tsp_file_t *f, int i, int j) {
+    long k = (long)i * f->n + j;
+    if (f->elt_size == 1) {
+        return ((const unsigned char *)f->data)[k];
+    }
+    if (f->elt_size == 2) {
+        return ((const unsigned short *)f->data)[k];
+    }
+    return ((const int *)f->data)[k];
+}
+
+/* A one-way arc of a sparse instance. */
+typedef struct {
+    int from;
+    int to;
+    int cost;
+} tsp_arc_t;
+
+extern tsp_file_t *tsp_open(char *file_name);
+extern tsp_file_t *tsp_from_ints(int *tsp, int n);
+extern tsp_file_t *tsp_random(int n, int seed);
+extern void tsp_close(tsp_file_t *f);
+extern int *tsp_to_ints(tsp_file_t *f);
+extern void tsp_print(tsp_file_t *f, int seed);
+extern int tsp_symmetric(tsp_file_t *f);
+extern int tsp_tour_length(tsp_file_t *f, int *perm);
+extern int tsp_tour_length_from(tsp_file_t *f, int *perm, int *prefix, int from);
+extern int tsp_tour_swap(tsp_file_t *f, int *perm, int a, int b);
+extern int *load_tsp(char *file_name, int *n);
+extern void write_tsp_binary(int *tsp, int n, char *file_name);
+extern tsp_arc_t *read_dimacs(char *file_name, int *n, long *m);
@@ -1,3 +1,10 @@
+/**
+ * Matrix addition with MPI: the master generates A and B, sends them out in
+ * stripes of rows, and collects the sums into c.txt.
+ *
+ * Build: mpicc -std=gnu99 -O2 dist_mat_add.c matrix_generator.c elt_kernels.c
+ * Run:   mpirun -np 4 ./a.out
+ */
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -5,6 +12,7 @@
 #include <time.h>
 #include <string.h>
 #include "matrix_generator.h"
+#include "elt_kernels.h"
 
 #define MAT_GET(matrix, columns, i, j) *(matrix + (colums * i) + j)
 #define MASTER_CORE 0
@@ -130,11 +138,13 @@ void mat_add (mystery_box_t *my_box) {
     int cols        = my_box->cols;
     int size        = proc_load * cols;
     int rank        = my_box->rank;
-    int *c          = malloc(size * sizeof(int));
+    int *c          = elt_alloc(size * sizeof(int));
     /* Addition computation */
-    for(int i = 0; i < size; i++) {
-        *(c + i) = *(my_box->a_stripe + i) + *(my_box->b_stripe + i);
-        if(DEBUG) {printf("%d: %d - ", rank, *(c+i));}
+    elt_add_i32(c, my_box->a_stripe, my_box->b_stripe, size);
+    if(DEBUG) {
+        for(int i = 0; i < size; i++) {
+            printf("%d: %d - ", rank, *(c+i));
+        }
     }
     MPI_Barrier(MPI_COMM_WORLD);
     my_box->c_stripe = c;
@@ -201,6 +211,7 @@ int main(int argc, char **argv) {
     MPI_Init(&argc, &argv);
     MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    select_elt_kernels();
     if(rows < num_procs) {
         fprintf(stderr, "Invalid number of processors, exiting...\n");
         exit(1);
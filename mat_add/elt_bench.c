@@ -0,0 +1,195 @@
+/**
+ * Benchmark of the element-wise kernels in elt_kernels.c.
+ *
+ * Runs every kernel on every type with each build this CPU supports
+ * (scalar, vector, avx2, avx512), checks the results agree with the scalar
+ * build and prints the memory bandwidth of each, the fastest of -r runs.
+ * Small arrays are run many times per timing, so the clock can see them.
+ * Arrays of -n elements that fit in cache show the compute; large ones
+ * show how close each build gets to memory speed.
+ *
+ * Build: gcc -std=gnu11 -O2 elt_bench.c elt_kernels.c -lm
+ * Run:   ./a.out -n 1000000 -r 20
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include "elt_kernels.h"
+
+#define ONE_BILLION (double)1000000000.0
+
+static char *builds[] = { "scalar", "vector", "avx2", "avx512" };
+#define NUM_BUILDS 4
+static char *ops[] = { "add", "sub", "scale", "axpy", "fused" };
+#define NUM_OPS 5
+static char *types[] = { "i32", "i64", "f32", "f64" };
+static size_t type_sizes[] = { 4, 8, 4, 8 };
+#define NUM_TYPES 4
+
+long num_elements = 1000000;
+int repeats = 10;
+
+/**
+ * Method for getting the current time
+ */
+double now(void) {
+    struct timespec current_time;
+    clock_gettime(CLOCK_REALTIME, &current_time);
+    return current_time.tv_sec + (current_time.tv_nsec / ONE_BILLION);
+}
+
+/* Run op on type once: z = op(x, y) with a = 3, b = -2, c = 7. */
+void run_kernel(int op, int type, void *z, void *x, void *y, long n) {
+    switch(type * NUM_OPS + op) {
+    case 0: elt_add_i32(z, x, y, n); break;
+    case 1: elt_sub_i32(z, x, y, n); break;
+    case 2: elt_scale_i32(z, 3, x, n); break;
+    case 3: elt_axpy_i32(z, 3, x, y, n); break;
+    case 4: elt_fused_i32(z, 3, x, -2, y, 7, n); break;
+    case 5: elt_add_i64(z, x, y, n); break;
+    case 6: elt_sub_i64(z, x, y, n); break;
+    case 7: elt_scale_i64(z, 3, x, n); break;
+    case 8: elt_axpy_i64(z, 3, x, y, n); break;
+    case 9: elt_fused_i64(z, 3, x, -2, y, 7, n); break;
+    case 10: elt_add_f32(z, x, y, n); break;
+    case 11: elt_sub_f32(z, x, y, n); break;
+    case 12: elt_scale_f32(z, 3, x, n); break;
+    case 13: elt_axpy_f32(z, 3, x, y, n); break;
+    case 14: elt_fused_f32(z, 3, x, -2, y, 7, n); break;
+    case 15: elt_add_f64(z, x, y, n); break;
+    case 16: elt_sub_f64(z, x, y, n); break;
+    case 17: elt_scale_f64(z, 3, x, n); break;
+    case 18: elt_axpy_f64(z, 3, x, y, n); break;
+    case 19: elt_fused_f64(z, 3, x, -2, y, 7, n); break;
+    }
+}
+
+/* Does z match the scalar build's result? Floats may differ in the last
+   bits where a build fuses multiply-adds, relative to the size of the
+   terms rather than of the result, which can cancel to nothing. */
+int same_result(int type, void *z, void *expected, long n) {
+    for(long i = 0; i < n; i++) {
+        double got, want;
+        switch(type) {
+        case 0: got = ((int32_t *)z)[i]; want = ((int32_t *)expected)[i]; break;
+        case 1: got = ((int64_t *)z)[i]; want = ((int64_t *)expected)[i]; break;
+        case 2: got = ((float *)z)[i]; want = ((float *)expected)[i]; break;
+        default: got = ((double *)z)[i]; want = ((double *)expected)[i]; break;
+        }
+        double slack = type >= 2 ? 1e-5 * (1.0 + fabs(want)) : 0.0;
+        if(fabs(got - want) > slack) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void fill(int type, void *array, long n, int seed) {
+    srandom(seed);
+    for(long i = 0; i < n; i++) {
+        int value = random() / (RAND_MAX / 100);
+        switch(type) {
+        case 0: ((int32_t *)array)[i] = value; break;
+        case 1: ((int64_t *)array)[i] = value; break;
+        case 2: ((float *)array)[i] = value / 7.0f; break;
+        default: ((double *)array)[i] = value / 7.0; break;
+        }
+    }
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -n <elements per array>\n");
+    fprintf(stderr, "   -r <runs per kernel; the fastest counts>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int ch;
+    while ((ch = getopt(argc, argv, "hn:r:")) != -1) {
+        switch (ch) {
+        case 'n':
+            num_elements = atol(optarg);
+            break;
+        case 'r':
+            repeats = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (num_elements < 1 || repeats < 1) {
+        fprintf(stderr, "Need at least 1 element and 1 run\n");
+        exit(1);
+    }
+
+    /* Which builds run here: ask for each and see what is picked. */
+    int available[NUM_BUILDS];
+    for (int b = 0; b < NUM_BUILDS; b++) {
+        setenv("ELT_KERNELS", builds[b], 1);
+        select_elt_kernels();
+        available[b] = strcmp(elt_kernels_name, builds[b]) == 0;
+    }
+
+    long n = num_elements;
+    long passes = 10000000 / n > 1 ? 10000000 / n : 1;
+    void *x = elt_alloc(n * 8);
+    void *y = elt_alloc(n * 8);
+    void *z = elt_alloc(n * 8);
+    void *expected = elt_alloc(n * 8);
+
+    printf("%-6s %-4s", "op", "type");
+    for (int b = 0; b < NUM_BUILDS; b++) {
+        printf(" %9s", available[b] ? builds[b] : "-");
+    }
+    printf("   (GB/s)\n");
+    for (int type = 0; type < NUM_TYPES; type++) {
+        fill(type, x, n, 1);
+        fill(type, y, n, 2);
+        for (int op = 0; op < NUM_OPS; op++) {
+            /* Arrays read and written */
+            double bytes = (double)n * type_sizes[type] * (op == 2 ? 2 : 3);
+            printf("%-6s %-4s", ops[op], types[type]);
+            for (int b = 0; b < NUM_BUILDS; b++) {
+                if (!available[b]) {
+                    printf(" %9s", "-");
+                    continue;
+                }
+                setenv("ELT_KERNELS", builds[b], 1);
+                select_elt_kernels();
+                double fastest = 0.0;
+                for (int r = 0; r < repeats; r++) {
+                    double start_time = now();
+                    for (long k = 0; k < passes; k++) {
+                        run_kernel(op, type, z, x, y, n);
+                    }
+                    double elapsed = (now() - start_time) / passes;
+                    if (r == 0 || elapsed < fastest) {
+                        fastest = elapsed;
+                    }
+                }
+                if (b == 0) {
+                    memcpy(expected, z, n * type_sizes[type]);
+                }
+                else if (!same_result(type, z, expected, n)) {
+                    fprintf(stderr, "\n%s %s: the %s kernel disagrees with the scalar one\n",
+                            ops[op], types[type], builds[b]);
+                    exit(1);
+                }
+                printf(" %9.2f", fastest > 0 ? bytes / fastest / ONE_BILLION : 0.0);
+            }
+            printf("\n");
+        }
+    }
+
+    free(x);
+    free(y);
+    free(z);
+    free(expected);
+    return 0;
+}
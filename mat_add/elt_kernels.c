@@ -0,0 +1,164 @@
+/**
+ * Element-wise array kernels: add, sub, scale, axpy and the fused
+ * z = a * x + b * y + c, over int32, int64, float and double.
+ *
+ * Every kernel is written once, in GCC vector extensions, and built for
+ * several vector widths: 16 bytes (SSE2 on x86-64, NEON on ARM), 32 (AVX2)
+ * and 64 (AVX-512). select_elt_kernels() picks the widest one this CPU
+ * runs, and a scalar build is always there as a fallback. The fused kernel
+ * makes one pass for what would otherwise take a scale, an axpy and an
+ * add, each writing a whole intermediate array.
+ *
+ * Loads and stores are unaligned, so any pointers work, but arrays from
+ * elt_alloc() start on a cache line and never split a vector across two.
+ * Where the instruction set has fused multiply-add (AVX-512 here) the
+ * compiler uses it for a * x + y, so float results can differ from the
+ * other builds in the last bit; integer results never do.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "elt_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SIMD 1
+#endif
+
+enum { ELT_ADD, ELT_SUB, ELT_SCALE, ELT_AXPY, ELT_FUSED, ELT_OPS };
+enum { ELT_I32, ELT_I64, ELT_F32, ELT_F64, ELT_TYPES };
+
+/* A kernel on any type: the scalars are s[0], s[1], s[2] (a, b, c). */
+typedef void (*elt_kernel_t)(void *z, const void *x, const void *y, const void *s, long n);
+typedef elt_kernel_t elt_table_t[ELT_OPS][ELT_TYPES];
+
+/* z[i] = EXPR over vectors of W bytes of T, then the elements left over
+   one at a time. EXPR sees X and Y (elements of x and y) and a, b, c. */
+#define ELT_KERNEL(op, tn, T, isa, attr, W, uses_y, EXPR)                     \
+    attr static void op##_##tn##_##isa(void *zp, const void *xp,             \
+                                       const void *yp, const void *sp,       \
+                                       long n) {                             \
+        typedef T elt_t;                                                     \
+        typedef elt_t vec_t __attribute__((vector_size(W)));                 \
+        elt_t *z = zp;                                                       \
+        const elt_t *x = xp;                                                 \
+        const elt_t *y = yp;                                                 \
+        const elt_t *s = sp;                                                 \
+        const elt_t a = s[0], b = s[1], c = s[2];                            \
+        const long lanes = W / sizeof(elt_t);                                \
+        (void)a, (void)b, (void)c, (void)y;                                  \
+        long i = 0;                                                          \
+        for(; i + lanes <= n; i += lanes) {                                  \
+            vec_t X, Y = { 0 };                                              \
+            memcpy(&X, x + i, W);                                            \
+            if(uses_y) {                                                     \
+                memcpy(&Y, y + i, W);                                        \
+            }                                                                \
+            (void)Y;                                                         \
+            vec_t Z = EXPR;                                                  \
+            memcpy(z + i, &Z, W);                                            \
+        }                                                                    \
+        for(; i < n; i++) {                                                  \
+            elt_t X = x[i];                                                  \
+            elt_t Y = uses_y ? y[i] : 0;                                     \
+            (void)Y;                                                         \
+            z[i] = EXPR;                                                     \
+        }                                                                    \
+    }
+
+#define ELT_TYPE_KERNELS(tn, T, isa, attr, W)                                 \
+    ELT_KERNEL(add, tn, T, isa, attr, W, 1, X + Y)                           \
+    ELT_KERNEL(sub, tn, T, isa, attr, W, 1, X - Y)                           \
+    ELT_KERNEL(scale, tn, T, isa, attr, W, 0, a * X)                         \
+    ELT_KERNEL(axpy, tn, T, isa, attr, W, 1, a * X + Y)                      \
+    ELT_KERNEL(fused, tn, T, isa, attr, W, 1, a * X + b * Y + c)
+
+/* All the kernels for one instruction set, and its table. W of
+   sizeof(elt_t) is one element at a time. */
+#define ELT_KERNELS(isa, attr, W)                                             \
+    ELT_TYPE_KERNELS(i32, int32_t, isa, attr, W)                             \
+    ELT_TYPE_KERNELS(i64, int64_t, isa, attr, W)                             \
+    ELT_TYPE_KERNELS(f32, float, isa, attr, W)                               \
+    ELT_TYPE_KERNELS(f64, double, isa, attr, W)                              \
+    static elt_table_t isa##_kernels = {                                     \
+        { add_i32_##isa, add_i64_##isa, add_f32_##isa, add_f64_##isa },      \
+        { sub_i32_##isa, sub_i64_##isa, sub_f32_##isa, sub_f64_##isa },      \
+        { scale_i32_##isa, scale_i64_##isa, scale_f32_##isa, scale_f64_##isa }, \
+        { axpy_i32_##isa, axpy_i64_##isa, axpy_f32_##isa, axpy_f64_##isa },  \
+        { fused_i32_##isa, fused_i64_##isa, fused_f32_##isa, fused_f64_##isa } \
+    };
+
+ELT_KERNELS(scalar, , sizeof(elt_t))
+ELT_KERNELS(vector, , 16)
+#ifdef HAVE_X86_SIMD
+ELT_KERNELS(avx2, __attribute__((target("avx2"))), 32)
+ELT_KERNELS(avx512, __attribute__((target("avx512f"))), 64)
+#endif
+
+static elt_table_t *elt_kernels = &scalar_kernels;
+const char *elt_kernels_name = "scalar";
+
+/* Use the widest kernels this CPU can run. Setting ELT_KERNELS to
+   "scalar", "vector" or "avx2" in the environment caps them, for cross
+   checks. Until this is called, the scalar kernels run. */
+void select_elt_kernels(void) {
+    const char *cap = getenv("ELT_KERNELS");
+    if(cap != NULL && strcmp(cap, "scalar") == 0) {
+        elt_kernels = &scalar_kernels;
+        elt_kernels_name = "scalar";
+        return;
+    }
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    int allow_256 = (cap == NULL || strcmp(cap, "vector") != 0);
+    int allow_512 = allow_256 && (cap == NULL || strcmp(cap, "avx2") != 0);
+    if(allow_512 && __builtin_cpu_supports("avx512f")) {
+        elt_kernels = &avx512_kernels;
+        elt_kernels_name = "avx512";
+        return;
+    }
+    if(allow_256 && __builtin_cpu_supports("avx2")) {
+        elt_kernels = &avx2_kernels;
+        elt_kernels_name = "avx2";
+        return;
+    }
+#endif
+    elt_kernels = &vector_kernels;
+    elt_kernels_name = "vector";
+}
+
+/* Memory aligned to ELT_ALIGN; free with free(). */
+void *elt_alloc(size_t bytes) {
+    void *memory;
+    if(posix_memalign(&memory, ELT_ALIGN, bytes > 0 ? bytes : ELT_ALIGN) != 0) {
+        fprintf(stderr, "Can't allocate %zu bytes\n", bytes);
+        exit(1);
+    }
+    return memory;
+}
+
+#define ELT_ENTRY_POINTS(tn, T, type)                                          \
+    void elt_add_##tn(T *z, const T *x, const T *y, long n) {                 \
+        T s[3] = { 0, 0, 0 };                                                 \
+        (*elt_kernels)[ELT_ADD][type](z, x, y, s, n);                         \
+    }                                                                         \
+    void elt_sub_##tn(T *z, const T *x, const T *y, long n) {                 \
+        T s[3] = { 0, 0, 0 };                                                 \
+        (*elt_kernels)[ELT_SUB][type](z, x, y, s, n);                         \
+    }                                                                         \
+    void elt_scale_##tn(T *z, T a, const T *x, long n) {                      \
+        T s[3] = { a, 0, 0 };                                                 \
+        (*elt_kernels)[ELT_SCALE][type](z, x, NULL, s, n);                    \
+    }                                                                         \
+    void elt_axpy_##tn(T *z, T a, const T *x, const T *y, long n) {           \
+        T s[3] = { a, 0, 0 };                                                 \
+        (*elt_kernels)[ELT_AXPY][type](z, x, y, s, n);                        \
+    }                                                                         \
+    void elt_fused_##tn(T *z, T a, const T *x, T b, const T *y, T c, long n) { \
+        T s[3] = { a, b, c };                                                 \
+        (*elt_kernels)[ELT_FUSED][type](z, x, y, s, n);                       \
+    }
+
+ELT_ENTRY_POINTS(i32, int32_t, ELT_I32)
+ELT_ENTRY_POINTS(i64, int64_t, ELT_I64)
+ELT_ENTRY_POINTS(f32, float, ELT_F32)
+ELT_ENTRY_POINTS(f64, double, ELT_F64)
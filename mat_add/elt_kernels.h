@@ -0,0 +1,40 @@
+/* Element-wise array kernels; see elt_kernels.c. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Alignment of elt_alloc() memory: a cache line, and the widest vector. */
+#define ELT_ALIGN 64
+
+extern void select_elt_kernels(void);
+extern const char *elt_kernels_name;
+extern void *elt_alloc(size_t bytes);
+
+/* z[i] = x[i] + y[i] */
+extern void elt_add_i32(int32_t *z, const int32_t *x, const int32_t *y, long n);
+extern void elt_add_i64(int64_t *z, const int64_t *x, const int64_t *y, long n);
+extern void elt_add_f32(float *z, const float *x, const float *y, long n);
+extern void elt_add_f64(double *z, const double *x, const double *y, long n);
+
+/* z[i] = x[i] - y[i] */
+extern void elt_sub_i32(int32_t *z, const int32_t *x, const int32_t *y, long n);
+extern void elt_sub_i64(int64_t *z, const int64_t *x, const int64_t *y, long n);
+extern void elt_sub_f32(float *z, const float *x, const float *y, long n);
+extern void elt_sub_f64(double *z, const double *x, const double *y, long n);
+
+/* z[i] = a * x[i] */
+extern void elt_scale_i32(int32_t *z, int32_t a, const int32_t *x, long n);
+extern void elt_scale_i64(int64_t *z, int64_t a, const int64_t *x, long n);
+extern void elt_scale_f32(float *z, float a, const float *x, long n);
+extern void elt_scale_f64(double *z, double a, const double *x, long n);
+
+/* z[i] = a * x[i] + y[i] */
+extern void elt_axpy_i32(int32_t *z, int32_t a, const int32_t *x, const int32_t *y, long n);
+extern void elt_axpy_i64(int64_t *z, int64_t a, const int64_t *x, const int64_t *y, long n);
+extern void elt_axpy_f32(float *z, float a, const float *x, const float *y, long n);
+extern void elt_axpy_f64(double *z, double a, const double *x, const double *y, long n);
+
+/* z[i] = a * x[i] + b * y[i] + c, in one pass */
+extern void elt_fused_i32(int32_t *z, int32_t a, const int32_t *x, int32_t b, const int32_t *y, int32_t c, long n);
+extern void elt_fused_i64(int64_t *z, int64_t a, const int64_t *x, int64_t b, const int64_t *y, int64_t c, long n);
+extern void elt_fused_f32(float *z, float a, const float *x, float b, const float *y, float c, long n);
+extern void elt_fused_f64(double *z, double a, const double *x, double b, const double *y, double c, long n);
@@ -1,7 +1,15 @@
+/**
+ * Serial matrix addition: C = A + B for a.txt and b.txt, written to
+ * c_test.txt.
+ *
+ * Build: gcc -std=gnu99 -O2 mat_add.c matrix_generator.c elt_kernels.c
+ * Run:   ./a.out
+ */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include "matrix_generator.h"
+#include "elt_kernels.h"
 
 //#define MAT_ELT(matrix, cols, row, col) *(matrix + (row * cols) + col)
 
@@ -11,11 +19,7 @@
  * the addition of the first two.
  */
 void mat_add(int *a, int *b, int *c, int rows, int cols) {
-    for(int i = 0; i < rows; i++) {
-        for(int j = 0; j < cols; j++) {
-            MAT_ELT(c, cols, i, j) = MAT_ELT(a, cols, i, j) + MAT_ELT(b, cols, i, j);
-        }
-    }
+    elt_add_i32(c, a, b, (long)rows * cols);
 }
 
 /**
@@ -64,12 +68,13 @@ int main(int argc, char **argv) {
     mat_print("C After", (int *)C, 2, 3);
     write_matrix((int *)C, 30, 30)
     */
+    select_elt_kernels();
     int rowcol = 512;
     // generate_matrix(rowcol, rowcol, "a_test.txt");
     // generate_matrix(rowcol, rowcol, "b_test.txt");
     int *a = read_matrix(&rowcol, &rowcol, "a.txt");
     int *b = read_matrix(&rowcol, &rowcol, "b.txt");
-    int *c = malloc(rowcol * rowcol * sizeof(int));
+    int *c = elt_alloc(rowcol * rowcol * sizeof(int));
     mat_add(a, b, c, rowcol, rowcol);
     write_matrix(c, rowcol, rowcol, "c_test.txt");
 
@@ -0,0 +1,81 @@
+/**
+ * Convert matrix files between the text and binary formats.
+ *
+ * The input may be either format (see matrix_generator.c); the output is
+ * binary if its name ends in ".bin" and text otherwise. The mat_mult
+ * programs read the same formats. Text is parsed and printed by -t threads
+ * (matrix_text.c), or with stdio by -t 0, to compare the two.
+ *
+ * Build: gcc -std=gnu99 -O2 -pthread matrix_convert.c matrix_generator.c matrix_text.c
+ * Run:   ./a.out -i a.txt -o a.bin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "matrix_generator.h"
+#include "matrix_text.h"
+
+#define ONE_BILLION (double)1000000000.0
+
+/**
+ * Method for getting the current time
+ */
+double now(void) {
+    struct timespec current_time;
+    clock_gettime(CLOCK_REALTIME, &current_time);
+    return current_time.tv_sec + (current_time.tv_nsec / ONE_BILLION);
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -i <input matrix, text or binary>\n");
+    fprintf(stderr, "   -o <output matrix; binary if it ends in .bin>\n");
+    fprintf(stderr, "   -t <threads for text; 0 for stdio>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *in_name = NULL;
+    char *out_name = NULL;
+    int num_threads = 1;
+    int ch;
+    while ((ch = getopt(argc, argv, "hi:o:t:")) != -1) {
+        switch (ch) {
+        case 'i':
+            in_name = optarg;
+            break;
+        case 'o':
+            out_name = optarg;
+            break;
+        case 't':
+            num_threads = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (in_name == NULL || out_name == NULL || num_threads < 0) {
+        usage(argv[0]);
+    }
+
+    double start_time = now();
+    matrix_file_t *m = num_threads > 0 ? open_matrix_parallel(in_name, num_threads) : open_matrix(in_name);
+    double read_time = now() - start_time;
+    start_time = now();
+    if (num_threads > 0) {
+        write_matrix_parallel(m->data, m->rows, m->cols, out_name, num_threads);
+    }
+    else {
+        write_matrix(m->data, m->rows, m->cols, out_name);
+    }
+    double write_time = now() - start_time;
+
+    printf("Converted a %dx%d matrix from %s (%s, read in %5.3f seconds) to %s (%s, written in %5.3f seconds)\n",
+           m->rows, m->cols, in_name, m->map != NULL ? "binary" : "text", read_time,
+           out_name, is_binary_name(out_name) ? "binary" : "text", write_time);
+    close_matrix(m);
+    return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * Adding matrices too large to hold in memory.
+ *
+ * stream_mat_add() never holds more than a few blocks of elements, taken in
+ * row order, so a block may hold many rows or only part of one. Blocks go
+ * through a pipeline of three threads and three slots: while a reader thread
+ * reads the next block of A and B into one slot and a writer thread writes
+ * the last block of C out of another, the calling thread adds the block in
+ * between in the third. So reading, adding and writing overlap (with two
+ * slots, the reader would wait for the writer), and the memory used is the
+ * budget given, whatever the size of the matrices.
+ *
+ * Binary files are read and written with pread()/pwrite() at the offset of
+ * each block's first element, and the inputs dropped from the page cache
+ * once read, so the cache does not grow to the size of the files either.
+ * Text files work too, read and written in order with stdio, but only binary
+ * ones are fast.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "matrix_generator.h"
+#include "matrix_stream.h"
+#include "elt_kernels.h"
+
+#define STREAM_SLOTS 3
+
+/* Where a slot is in the pipeline. */
+#define SLOT_FREE 0      /* Waiting for the reader */
+#define SLOT_READ 1      /* Waiting to be added */
+#define SLOT_ADDED 2     /* Waiting for the writer */
+
+/* A matrix file being read or written a block of elements at a time. */
+typedef struct {
+    char *file_name;
+    int rows;
+    int cols;
+    int fd;              /* Binary files */
+    off_t data_offset;
+    FILE *fp;            /* Text files */
+} matrix_stream_t;
+
+typedef struct {
+    int *a;              /* A's elements, then A + B */
+    int *b;
+    size_t first;        /* Index of the first element, in row order */
+    size_t count;
+    int state;
+} stream_slot_t;
+
+typedef struct {
+    matrix_stream_t *a;
+    matrix_stream_t *b;
+    matrix_stream_t *c;
+    size_t block_size;   /* Elements per block */
+    size_t num_blocks;
+    stream_slot_t slots[STREAM_SLOTS];
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} stream_pipe_t;
+
+static matrix_stream_t *stream_open_read(char *file_name) {
+    matrix_stream_t *s = malloc(sizeof(matrix_stream_t));
+    s->file_name = file_name;
+    s->fp = NULL;
+    if((s->fd = open(file_name, O_RDONLY)) < 0) {
+        fprintf(stderr, "Problem parsing file.\n");
+        exit(1);
+    }
+    if(read_matrix_header(s->fd, file_name, &s->rows, &s->cols, &s->data_offset)) {
+        posix_fadvise(s->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        return s;
+    }
+    close(s->fd);
+    s->fd = -1;
+    if((s->fp = fopen(file_name, "r")) == NULL ||
+       fscanf(s->fp, "%d %d\n", &s->rows, &s->cols) != 2) {
+        fprintf(stderr, "Problem parsing file.\n");
+        exit(1);
+    }
+    return s;
+}
+
+static matrix_stream_t *stream_open_write(char *file_name, int rows, int cols) {
+    matrix_stream_t *s = malloc(sizeof(matrix_stream_t));
+    s->file_name = file_name;
+    s->rows = rows;
+    s->cols = cols;
+    s->fd = -1;
+    s->fp = NULL;
+    if(is_binary_name(file_name)) {
+        if((s->fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+            fprintf(stderr, "Can't open %s for writing\n", file_name);
+            exit(1);
+        }
+        s->data_offset = write_matrix_header(s->fd, rows, cols, file_name);
+    }
+    else {
+        if((s->fp = fopen(file_name, "w")) == NULL) {
+            fprintf(stderr, "Can't open %s for writing\n", file_name);
+            exit(1);
+        }
+        fprintf(s->fp, "%d %d\n", rows, cols);
+    }
+    return s;
+}
+
+/* Blocks are read and written in order, so text files need no seeking. */
+static void stream_read(matrix_stream_t *s, int *elements, size_t first, size_t count) {
+    if(s->fp != NULL) {
+        for(size_t i = 0; i < count; i++) {
+            if(fscanf(s->fp, "%d", elements + i) != 1) {
+                fprintf(stderr, "Problem parsing file.\n");
+                exit(1);
+            }
+        }
+        return;
+    }
+
+    off_t start = s->data_offset + (off_t)first * sizeof(int);
+    size_t done = 0;
+    while(done < count * sizeof(int)) {
+        ssize_t got = pread(s->fd, (char *)elements + done, count * sizeof(int) - done, start + done);
+        if(got <= 0) {
+            fprintf(stderr, "%s: read failed\n", s->file_name);
+            exit(1);
+        }
+        done += got;
+    }
+    posix_fadvise(s->fd, start, done, POSIX_FADV_DONTNEED);
+}
+
+/* A newline ends each row of a text file, wherever the blocks split it,
+   as in write_matrix(). */
+static void stream_write(matrix_stream_t *s, int *elements, size_t first, size_t count) {
+    if(s->fp != NULL) {
+        for(size_t i = 0; i < count; i++) {
+            fprintf(s->fp, " %3d", elements[i]);
+            if((first + i + 1) % s->cols == 0) {
+                fprintf(s->fp, "\n");
+            }
+        }
+        return;
+    }
+
+    size_t bytes = count * sizeof(int);
+    off_t start = s->data_offset + (off_t)first * sizeof(int);
+    size_t done = 0;
+    while(done < bytes) {
+        ssize_t written = pwrite(s->fd, (char *)elements + done, bytes - done, start + done);
+        if(written < 0) {
+            fprintf(stderr, "%s: write failed\n", s->file_name);
+            exit(1);
+        }
+        done += written;
+    }
+}
+
+static void stream_close(matrix_stream_t *s) {
+    if((s->fp != NULL && fclose(s->fp) != 0) || (s->fd >= 0 && close(s->fd) != 0)) {
+        fprintf(stderr, "%s: write failed\n", s->file_name);
+        exit(1);
+    }
+    free(s);
+}
+
+/* Ints that fit in bytes, at least one, and no more than total. */
+static size_t block_elements(long bytes, size_t total) {
+    size_t elements = bytes > 0 ? (size_t)bytes / sizeof(int) : 0;
+    elements = elements < 1 ? 1 : elements;
+    return elements > total && total > 0 ? total : elements;
+}
+
+static void wait_for(stream_pipe_t *pipe, stream_slot_t *slot, int state) {
+    pthread_mutex_lock(&pipe->lock);
+    while(slot->state != state) {
+        pthread_cond_wait(&pipe->changed, &pipe->lock);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+static void set_state(stream_pipe_t *pipe, stream_slot_t *slot, int state) {
+    pthread_mutex_lock(&pipe->lock);
+    slot->state = state;
+    pthread_cond_broadcast(&pipe->changed);
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+static void *stream_reader(void *parameter) {
+    stream_pipe_t *pipe = (stream_pipe_t *)parameter;
+    size_t total = (size_t)pipe->a->rows * pipe->a->cols;
+    for(size_t k = 0; k < pipe->num_blocks; k++) {
+        stream_slot_t *slot = &pipe->slots[k % STREAM_SLOTS];
+        wait_for(pipe, slot, SLOT_FREE);
+        slot->first = k * pipe->block_size;
+        slot->count = total - slot->first < pipe->block_size ? total - slot->first : pipe->block_size;
+        stream_read(pipe->a, slot->a, slot->first, slot->count);
+        stream_read(pipe->b, slot->b, slot->first, slot->count);
+        set_state(pipe, slot, SLOT_READ);
+    }
+    return NULL;
+}
+
+static void *stream_writer(void *parameter) {
+    stream_pipe_t *pipe = (stream_pipe_t *)parameter;
+    for(size_t k = 0; k < pipe->num_blocks; k++) {
+        stream_slot_t *slot = &pipe->slots[k % STREAM_SLOTS];
+        wait_for(pipe, slot, SLOT_ADDED);
+        stream_write(pipe->c, slot->a, slot->first, slot->count);
+        set_state(pipe, slot, SLOT_FREE);
+    }
+    return NULL;
+}
+
+/* C = A + B, a block at a time, in at most budget bytes of blocks. A and B
+   may be text or binary files; C is binary if its name ends in ".bin". */
+void stream_mat_add(char *a_name, char *b_name, char *c_name, long budget) {
+    stream_pipe_t pipe;
+    pipe.a = stream_open_read(a_name);
+    pipe.b = stream_open_read(b_name);
+    int rows = pipe.a->rows;
+    int cols = pipe.a->cols;
+    if(pipe.b->rows != rows || pipe.b->cols != cols) {
+        fprintf(stderr, "Can't add a %dx%d matrix to a %dx%d one\n", pipe.b->rows, pipe.b->cols, rows, cols);
+        exit(1);
+    }
+    pipe.c = stream_open_write(c_name, rows, cols);
+    /* A block of each of A and B in each slot fits in the budget, however
+       long the rows are. */
+    size_t total = (size_t)rows * cols;
+    pipe.block_size = block_elements(budget / (STREAM_SLOTS * 2), total);
+    pipe.num_blocks = (total + pipe.block_size - 1) / pipe.block_size;
+    for(int s = 0; s < STREAM_SLOTS; s++) {
+        pipe.slots[s].a = elt_alloc(pipe.block_size * sizeof(int));
+        pipe.slots[s].b = elt_alloc(pipe.block_size * sizeof(int));
+        pipe.slots[s].state = SLOT_FREE;
+    }
+    pthread_mutex_init(&pipe.lock, NULL);
+    pthread_cond_init(&pipe.changed, NULL);
+
+    pthread_t reader, writer;
+    pthread_create(&reader, NULL, stream_reader, &pipe);
+    pthread_create(&writer, NULL, stream_writer, &pipe);
+    for(size_t k = 0; k < pipe.num_blocks; k++) {
+        stream_slot_t *slot = &pipe.slots[k % STREAM_SLOTS];
+        wait_for(&pipe, slot, SLOT_READ);
+        elt_add_i32(slot->a, slot->a, slot->b, (long)slot->count);
+        set_state(&pipe, slot, SLOT_ADDED);
+    }
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+
+    stream_close(pipe.a);
+    stream_close(pipe.b);
+    stream_close(pipe.c);
+    for(int s = 0; s < STREAM_SLOTS; s++) {
+        free(pipe.slots[s].a);
+        free(pipe.slots[s].b);
+    }
+    pthread_mutex_destroy(&pipe.lock);
+    pthread_cond_destroy(&pipe.changed);
+}
+
+/* generate_matrix() a block at a time, in at most budget bytes. The
+   elements are the ones generate_matrix() would make. */
+void generate_matrix_stream(int rows, int cols, char *file_name, long budget) {
+    matrix_stream_t *s = stream_open_write(file_name, rows, cols);
+    size_t total = (size_t)rows * cols;
+    size_t block = block_elements(budget, total);
+    int *matrix = malloc(block * sizeof(int));
+    for(size_t first = 0; first < total; first += block) {
+        size_t count = total - first < block ? total - first : block;
+        for(size_t i = 0; i < count; i++) {
+            matrix[i] = random() / (RAND_MAX / 100);
+        }
+        stream_write(s, matrix, first, count);
+    }
+    stream_close(s);
+    free(matrix);
+}
@@ -0,0 +1,4 @@
+/* Matrix addition out of core; see matrix_stream.c. */
+
+extern void stream_mat_add(char *a_name, char *b_name, char *c_name, long budget);
+extern void generate_matrix_stream(int rows, int cols, char *file_name, long budget);
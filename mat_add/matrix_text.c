@@ -0,0 +1,312 @@
+/**
+ * Reading and writing the text matrix format with several threads.
+ *
+ * open_matrix_parallel() maps the file and splits what follows the
+ * "rows cols" numbers into one chunk per thread, each starting after a
+ * space or newline, so one long line is split as well as many. The threads
+ * first count the numbers in their chunks, which tells each where its first
+ * element goes, then parse them with a plain digit loop in place of
+ * fscanf(). Like read_matrix(), it takes the numbers in any layout and
+ * ignores any after the rows * cols it needs. Both loops only compare bytes
+ * with ' ' and '0'..'9', so the counting one vectorizes.
+ *
+ * write_matrix_parallel() has each thread print a block of rows into its
+ * own buffer with a digit loop in place of fprintf(), then writes the
+ * buffers in order with one pwritev(). The output is byte for byte what
+ * write_matrix() prints; the buffers hold all of it, so they take about
+ * three times the memory of the matrix.
+ *
+ * Binary files (see matrix_generator.c) are passed through to the serial
+ * code, which has nothing to parse.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "matrix_generator.h"
+#include "matrix_text.h"
+
+/* Longest " %3d" of an int: a space, a sign and 10 digits. */
+#define MAX_ELT_TEXT 12
+
+/* One buffer per thread goes into a single pwritev(), under IOV_MAX. */
+#define MAX_TEXT_THREADS 256
+
+typedef struct {
+    const unsigned char *start;   /* Chunk of the text */
+    const unsigned char *end;
+    long first;                   /* Index of its first element */
+    long count;                   /* Number of elements in it to parse */
+    int *matrix;
+    int bad;                      /* Set if the chunk is not all numbers */
+} parse_chunk_t;
+
+typedef struct {
+    int *matrix;
+    int cols;
+    int first_row;
+    int num_rows;
+    char *text;
+    size_t len;
+} print_chunk_t;
+
+/* Count the numbers in a chunk: bytes above ' ' that follow one that
+   is not. The chunk starts after a space, so its first byte counts. */
+static void *count_chunk(void *parameter) {
+    parse_chunk_t *chunk = (parse_chunk_t *)parameter;
+    const unsigned char *s = chunk->start;
+    long len = chunk->end - chunk->start;
+    long count = (len > 0 && s[0] > ' ');
+    for(long i = 1; i < len; i++) {
+        count += (s[i] > ' ') & (s[i - 1] <= ' ');
+    }
+    chunk->count = count;
+    return NULL;
+}
+
+static void *parse_chunk(void *parameter) {
+    parse_chunk_t *chunk = (parse_chunk_t *)parameter;
+    const unsigned char *p = chunk->start;
+    const unsigned char *end = chunk->end;
+    int *out = chunk->matrix + chunk->first;
+    long count = 0;
+    while(count < chunk->count) {
+        while(p < end && *p <= ' ') {
+            p++;
+        }
+        int negative = (p < end && *p == '-');
+        p += (p < end && (*p == '-' || *p == '+'));
+        const unsigned char *digits = p;
+        unsigned int value = 0;
+        while(p < end && (unsigned int)(*p - '0') < 10) {
+            value = value * 10 + (*p - '0');
+            p++;
+        }
+        if(p == digits || (p < end && *p > ' ')) {
+            chunk->bad = 1;
+            return NULL;
+        }
+        out[count++] = negative ? (int)(0u - value) : (int)value;
+    }
+    return NULL;
+}
+
+/* Read a non-negative number of the header; NULL if there is none. */
+static const unsigned char *parse_size(const unsigned char *p, const unsigned char *end, int *size) {
+    while(p < end && *p <= ' ') {
+        p++;
+    }
+    long value = 0;
+    const unsigned char *digits = p;
+    while(p < end && (unsigned int)(*p - '0') < 10 && value <= 0x7fffffff) {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if(p == digits || value > 0x7fffffff) {
+        return NULL;
+    }
+    *size = (int)value;
+    return p;
+}
+
+/* Run fn on each of the chunks in its own thread, the last in this one. */
+static void run_chunks(void *(*fn)(void *), void *chunks, size_t chunk_size, int num_threads) {
+    pthread_t threads[num_threads];
+    for(int t = 0; t < num_threads - 1; t++) {
+        pthread_create(&threads[t], NULL, fn, (char *)chunks + t * chunk_size);
+    }
+    fn((char *)chunks + (num_threads - 1) * chunk_size);
+    for(int t = 0; t < num_threads - 1; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+static int text_threads(int num_threads) {
+    if(num_threads < 1) {
+        return 1;
+    }
+    return num_threads > MAX_TEXT_THREADS ? MAX_TEXT_THREADS : num_threads;
+}
+
+/* Open a matrix file of either format, parsing text with num_threads
+   threads. Close it with close_matrix(). */
+matrix_file_t *open_matrix_parallel(char *file_name, int num_threads) {
+    int fd = open(file_name, O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Problem parsing file.\n");
+        exit(1);
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "Problem parsing file.\n");
+        exit(1);
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        fprintf(stderr, "Can't map %s\n", file_name);
+        exit(1);
+    }
+    if(st.st_size >= 4 && memcmp(map, MATRIX_BINARY_MAGIC, 4) == 0) {
+        munmap(map, st.st_size);
+        return open_matrix(file_name);
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    const unsigned char *text = map;
+    const unsigned char *end = text + st.st_size;
+    int rows, cols;
+    const unsigned char *p = parse_size(text, end, &rows);
+    if(p != NULL) {
+        p = parse_size(p, end, &cols);
+    }
+    if(p == NULL) {
+        fprintf(stderr, "Problem parsing file.\n");
+        exit(1);
+    }
+
+    /* Chunks of about equal size, moved on past the next space. The first
+       starts right after cols, where the elements may follow on the same
+       line. */
+    num_threads = text_threads(num_threads);
+    parse_chunk_t chunks[num_threads];
+    size_t body = end - p;
+    const unsigned char *start = p;
+    for(int t = 0; t < num_threads; t++) {
+        const unsigned char *chunk_end = end;
+        if(t < num_threads - 1) {
+            chunk_end = p + body * (t + 1) / num_threads;
+            chunk_end = chunk_end < start ? start : chunk_end;
+            while(chunk_end < end && chunk_end[-1] > ' ') {
+                chunk_end++;
+            }
+        }
+        chunks[t].start = start;
+        chunks[t].end = chunk_end;
+        chunks[t].bad = 0;
+        start = chunk_end;
+    }
+    run_chunks(count_chunk, chunks, sizeof(parse_chunk_t), num_threads);
+
+    /* Elements past the last one needed are not parsed. */
+    long num_elements = (long)rows * cols;
+    long first = 0;
+    for(int t = 0; t < num_threads; t++) {
+        chunks[t].first = first;
+        first += chunks[t].count;
+        if(first > num_elements) {
+            chunks[t].count -= first - num_elements;
+            first = num_elements;
+        }
+    }
+    if(first != num_elements) {
+        fprintf(stderr, "%s: %ld elements for a %dx%d matrix\n", file_name, first, rows, cols);
+        exit(1);
+    }
+    int *matrix = malloc(num_elements * sizeof(int));
+    for(int t = 0; t < num_threads; t++) {
+        chunks[t].matrix = matrix;
+    }
+    run_chunks(parse_chunk, chunks, sizeof(parse_chunk_t), num_threads);
+    munmap(map, st.st_size);
+    for(int t = 0; t < num_threads; t++) {
+        if(chunks[t].bad) {
+            fprintf(stderr, "Problem parsing file.\n");
+            exit(1);
+        }
+    }
+
+    matrix_file_t *m = malloc(sizeof(matrix_file_t));
+    m->rows = rows;
+    m->cols = cols;
+    m->data = matrix;
+    m->map = NULL;
+    m->map_len = 0;
+    return m;
+}
+
+/* Print one element as " %3d" does; returns the end of it. */
+static char *print_elt(char *p, int value) {
+    char digits[MAX_ELT_TEXT];
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    int len = 0;
+    do {
+        digits[len++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while(magnitude > 0);
+    if(value < 0) {
+        digits[len++] = '-';
+    }
+    *p++ = ' ';
+    for(int pad = len; pad < 3; pad++) {
+        *p++ = ' ';
+    }
+    while(len > 0) {
+        *p++ = digits[--len];
+    }
+    return p;
+}
+
+static void *print_chunk(void *parameter) {
+    print_chunk_t *chunk = (print_chunk_t *)parameter;
+    int cols = chunk->cols;
+    chunk->text = malloc((size_t)chunk->num_rows * ((size_t)cols * MAX_ELT_TEXT + 1));
+    char *p = chunk->text;
+    for(int r = chunk->first_row; r < chunk->first_row + chunk->num_rows; r++) {
+        int *row = chunk->matrix + (long)r * cols;
+        for(int c = 0; c < cols; c++) {
+            p = print_elt(p, row[c]);
+        }
+        *p++ = '\n';
+    }
+    chunk->len = p - chunk->text;
+    return NULL;
+}
+
+/* Write a matrix as write_matrix() does, printing the text with
+   num_threads threads. */
+void write_matrix_parallel(int *matrix, int rows, int cols, char *file_name, int num_threads) {
+    if(is_binary_name(file_name)) {
+        write_matrix_binary(matrix, rows, cols, file_name);
+        return;
+    }
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        fprintf(stderr, "Can't open %s for writing\n", file_name);
+        exit(1);
+    }
+
+    num_threads = text_threads(num_threads);
+    if(num_threads > rows && rows > 0) {
+        num_threads = rows;
+    }
+    print_chunk_t chunks[num_threads];
+    for(int t = 0; t < num_threads; t++) {
+        chunks[t].matrix = matrix;
+        chunks[t].cols = cols;
+        chunks[t].first_row = (int)((long)rows * t / num_threads);
+        chunks[t].num_rows = (int)((long)rows * (t + 1) / num_threads) - chunks[t].first_row;
+    }
+    run_chunks(print_chunk, chunks, sizeof(print_chunk_t), num_threads);
+
+    char header[32];
+    struct iovec iov[num_threads + 1];
+    iov[0].iov_base = header;
+    iov[0].iov_len = snprintf(header, sizeof(header), "%d %d\n", rows, cols);
+    for(int t = 0; t < num_threads; t++) {
+        iov[t + 1].iov_base = chunks[t].text;
+        iov[t + 1].iov_len = chunks[t].len;
+    }
+    write_vectors(fd, iov, num_threads + 1, file_name);
+    if(close(fd) != 0) {
+        fprintf(stderr, "%s: write failed\n", file_name);
+        exit(1);
+    }
+    for(int t = 0; t < num_threads; t++) {
+        free(chunks[t].text);
+    }
+}
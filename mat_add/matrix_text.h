@@ -0,0 +1,5 @@
+/* Multithreaded text matrix I/O; see matrix_text.c. Include after
+   matrix_generator.h. */
+
+extern matrix_file_t *open_matrix_parallel(char *file_name, int num_threads);
+extern void write_matrix_parallel(int *matrix, int rows, int cols, char *file_name, int num_threads);
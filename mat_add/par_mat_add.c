@@ -1,8 +1,18 @@
-#include <pthread.h>
+/**
+ * Matrix addition with a thread pool (see thread_pool.c), reading and
+ * writing the matrices with the parallel text code of matrix_text.c, or
+ * in the binary format with -b.
+ *
+ * Build: gcc -std=gnu99 -O2 -pthread par_mat_add.c matrix_generator.c matrix_text.c thread_pool.c elt_kernels.c
+ * Run:   ./a.out -n 8 -b
+ */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include "matrix_generator.h"
+#include "matrix_text.h"
+#include "thread_pool.h"
+#include "elt_kernels.h"
 #include <string.h>
 #include <time.h>
 
@@ -12,15 +22,6 @@ int *A_Matrix;
 int *B_Matrix;
 int *C_Matrix;
 
-typedef struct {
-    int rows;
-    int cols;
-    int start;
-    int load;
-    int thread;
-    int num_threads;
-} mystery_box_t;
-
 /**
  * Method for getting the current time
  */
@@ -30,24 +31,19 @@ double now(void) {
     return current_time.tv_sec + (current_time.tv_nsec / ONE_BILLION);
 }
 
-void *mat_add(void *parameter) {
-    mystery_box_t *my_box = (mystery_box_t *)parameter;
-    int load = my_box->load;
-    int start = my_box->start;
-    int rows = my_box->rows;
-    int cols = my_box->cols;
-    int thread = my_box->thread;
-    int size = load * cols;
-    for(int i = 0; i < size; i++) {
-        //printf("%d: %d %d %d\n", thread, i, load, start);
-        *(C_Matrix + (start*thread) + i) = *(A_Matrix + (start*thread) + i) + *(B_Matrix + (start*thread) + i);
-    }
+/* C = A + B over elements [start, end); a pool_parallel_for() body. */
+void mat_add(void *parameter, long start, long end, int thread) {
+    elt_add_i32(C_Matrix + start, A_Matrix + start, B_Matrix + start, end - start);
 }
 
 int main(int argc, char **argv) {
     int num_threads = 1;
+    int binary = 0;
+    long grain = 0;
+    int pin = 0;
+    int repeats = 1;
     int ch;
-    while ((ch = getopt(argc, argv, "n:")) != -1)
+    while ((ch = getopt(argc, argv, "bg:n:pr:")) != -1)
     {
         switch (ch)
         {
@@ -58,63 +54,64 @@ int main(int argc, char **argv) {
                 exit(1);
             }
             break;
+        case 'b':
+            binary = 1;
+            break;
+        case 'g':
+            grain = atol(optarg);
+            break;
+        case 'p':
+            pin = 1;
+            break;
+        case 'r':
+            repeats = atoi(optarg);
+            if(repeats < 1) {
+                fprintf(stderr, "Invalid repeat count, exiting...\n");
+                exit(1);
+            }
+            break;
         default:
             fprintf(stderr, "Wrong runtime arguments, exiting...\n");
             exit(1);
         }
     }
 
+    select_elt_kernels();
     int rows = 2048;
     int cols = 2048;
-    generate_matrix(rows, cols, "a_parallel.txt");
-    generate_matrix(rows, cols, "b_parallel.txt");
-    A_Matrix = read_matrix(&rows, &cols, "a_parallel.txt");
-    B_Matrix = read_matrix(&rows, &cols, "b_parallel.txt");
+    /* With -b the matrices are binary: written in one call and mapped
+       back in, not printed and parsed. */
+    char *a_name = binary ? "a_parallel.bin" : "a_parallel.txt";
+    char *b_name = binary ? "b_parallel.bin" : "b_parallel.txt";
+    char *c_name = binary ? "c_parallel.bin" : "c_parallel.txt";
+    generate_matrix(rows, cols, a_name);
+    generate_matrix(rows, cols, b_name);
+    matrix_file_t *a_file = open_matrix_parallel(a_name, num_threads);
+    matrix_file_t *b_file = open_matrix_parallel(b_name, num_threads);
+    A_Matrix = a_file->data;
+    B_Matrix = b_file->data;
 
-    pthread_t threads[num_threads];
-    mystery_box_t *boxes[num_threads];
-    int size = rows * cols;
-    int load_size = size / num_threads;
-
-
-    for(int i = 0; i < num_threads; i++) {
-        int start = load_size * i;
-        if((size % num_threads != 0) && (i == num_threads - 1)) {
-            load_size = rows - start;
-        }
-        boxes[i] = malloc(sizeof(mystery_box_t));
-        boxes[i]->rows = rows;
-        boxes[i]->cols = cols;
-        boxes[i]->start = start;
-        boxes[i]->load = load_size;
-        boxes[i]->thread = i;
-        boxes[i]->num_threads = num_threads;
-    }
-
-    C_Matrix = malloc(rows * cols * sizeof(int));
+    /* The threads are started once, and C is first touched by the thread
+       that adds each part of it, unless -g deals the parts out as the
+       threads ask. -r repeats the addition on the same threads. */
+    thread_pool_t *pool = pool_create(num_threads, pin);
+    long size = (long)rows * cols;
+    C_Matrix = grain > 0 ? elt_alloc(size * sizeof(int)) : pool_alloc(pool, size * sizeof(int));
     double start_time = now();
-    for(int i = 0; i < num_threads; i++) {
-        pthread_create(&threads[i], NULL, mat_add, boxes[i]);
-    }
-    for(int i = 0; i < num_threads; i++) {
-        pthread_join( threads[i], NULL);
-        free(boxes[i]);
+    for(int r = 0; r < repeats; r++) {
+        pool_parallel_for(pool, 0, size, grain, mat_add, NULL);
     }
+    double add_time = now() - start_time;
 
-    FILE *fp;
-    if((fp = fopen("c_parallel.txt", "w")) == NULL) {
-        fprintf(stderr, "Can't open 'c_parallel.txt' for writing\n");
-        exit(1);
-    }
-    fprintf(fp, "%d %d\n", rows, cols);
-    for(int i = 0; i < rows; i++) {
-        for(int j = 0; j < cols; j++) {
-            fprintf(fp, " %3d", MAT_ELT(C_Matrix, cols, i, j));
-        }
-        fprintf(fp, "\n");
-    }
-    fclose(fp);
+    write_matrix_parallel(C_Matrix, rows, cols, c_name, num_threads);
     printf("On two %dx%d matrices, matrix addition on %d processors took %5.3f seconds\n", rows, cols, num_threads, now()-start_time);
+    if(repeats > 1) {
+        printf("Each of %d additions took %.6f seconds\n", repeats, add_time / repeats);
+    }
 
+    close_matrix(a_file);
+    close_matrix(b_file);
+    free(C_Matrix);
+    pool_destroy(pool);
     return 0;
 }
@@ -0,0 +1,98 @@
+/**
+ * Matrix addition for matrices larger than memory.
+ *
+ * Adds two matrix files a block at a time (see matrix_stream.c),
+ * in -k megabytes whatever their size. With -r and -c it first generates
+ * A and B of that size, the same way, so they never have to fit either.
+ * Use .bin names for the binary format; text works, but slowly.
+ *
+ * Build: gcc -std=gnu11 -O2 -pthread stream_mat_add.c matrix_stream.c matrix_generator.c elt_kernels.c
+ * Run:   ./a.out -r 32768 -c 32768 -a a_stream.bin -b b_stream.bin -o c_stream.bin -k 64
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "matrix_generator.h"
+#include "matrix_stream.h"
+#include "elt_kernels.h"
+
+#define ONE_BILLION (double)1000000000.0
+#define ONE_MEGABYTE (1024L * 1024L)
+
+/**
+ * Method for getting the current time
+ */
+double now(void) {
+    struct timespec current_time;
+    clock_gettime(CLOCK_REALTIME, &current_time);
+    return current_time.tv_sec + (current_time.tv_nsec / ONE_BILLION);
+}
+
+void usage(char *prog_name) {
+    fprintf(stderr, "usage: %s [flags]\n", prog_name);
+    fprintf(stderr, "   -h\n");
+    fprintf(stderr, "   -a <A matrix file>\n");
+    fprintf(stderr, "   -b <B matrix file>\n");
+    fprintf(stderr, "   -o <C matrix file; binary if it ends in .bin>\n");
+    fprintf(stderr, "   -k <megabytes to work in>\n");
+    fprintf(stderr, "   -r <rows; generate A and B first>\n");
+    fprintf(stderr, "   -c <columns; generate A and B first>\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char *a_name = NULL;
+    char *b_name = NULL;
+    char *c_name = NULL;
+    long budget = 64;
+    int rows = 0;
+    int cols = 0;
+    int ch;
+    while ((ch = getopt(argc, argv, "a:b:c:hk:o:r:")) != -1) {
+        switch (ch) {
+        case 'a':
+            a_name = optarg;
+            break;
+        case 'b':
+            b_name = optarg;
+            break;
+        case 'c':
+            cols = atoi(optarg);
+            break;
+        case 'k':
+            budget = atol(optarg);
+            break;
+        case 'o':
+            c_name = optarg;
+            break;
+        case 'r':
+            rows = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (a_name == NULL || b_name == NULL || c_name == NULL || budget < 1 || rows < 0 || cols < 0) {
+        usage(argv[0]);
+    }
+    budget *= ONE_MEGABYTE;
+
+    if (rows > 0 || cols > 0) {
+        if (rows < 1 || cols < 1) {
+            fprintf(stderr, "Need both -r and -c to generate matrices\n");
+            exit(1);
+        }
+        double start_time = now();
+        generate_matrix_stream(rows, cols, a_name, budget);
+        generate_matrix_stream(rows, cols, b_name, budget);
+        printf("Generating two %dx%d matrices took %5.3f seconds\n", rows, cols, now() - start_time);
+    }
+
+    select_elt_kernels();
+    double start_time = now();
+    stream_mat_add(a_name, b_name, c_name, budget);
+    printf("Streaming matrix addition in %ld MB took %5.3f seconds\n", budget / ONE_MEGABYTE, now() - start_time);
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * A pool of threads kept for many parallel loops.
+ *
+ * pool_create() starts the threads once; each pool_parallel_for() after
+ * that only wakes them, so a program that runs many short loops does not
+ * pay pthread_create() for each. The calling thread works as thread 0, so
+ * a pool of n threads starts n - 1.
+ *
+ * A loop is split one of two ways:
+ *
+ *   - grain 0: one contiguous block per thread, the same blocks every time
+ *     for the same range. Thread t always gets the same part of an array.
+ *
+ *   - grain > 0: blocks of grain indexes handed out as threads ask for
+ *     them, which balances uneven work.
+ *
+ * With pin set, thread t is bound to the t-th CPU the process may run on, so
+ * it stays next to its cache and memory. The calling thread is bound only
+ * while it runs a loop, and gets back the CPUs it had after, so threads it
+ * starts later (and later pools) are not all left on one CPU. pool_alloc()
+ * returns memory whose pages are first touched by the thread that gets them
+ * in a grain 0 loop over the same bytes, which places them on that thread's
+ * NUMA node.
+ *
+ * Build: add thread_pool.c to the program; link with -pthread.
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+struct thread_pool {
+    int num_threads;
+    pthread_t *threads;
+    pthread_mutex_t lock;
+    pthread_cond_t start;     /* A new loop, or shutdown */
+    pthread_cond_t done;      /* The last worker finished the loop */
+    long generation;          /* Loops started; workers wait for it to move */
+    int busy;                 /* Workers still in the current loop */
+    int shutdown;
+    int pin;
+    cpu_set_t allowed;        /* CPUs the caller could run on at the start */
+
+    /* The current loop */
+    range_fn_t fn;
+    void *arg;
+    long start_index;
+    long end_index;
+    long grain;
+    _Atomic long next;        /* Next block when grain > 0 */
+};
+
+typedef struct {
+    thread_pool_t *pool;
+    int thread;
+} worker_t;
+
+/* Bind the calling thread to the thread-th CPU of the set. */
+static void pin_thread(cpu_set_t *allowed, int thread) {
+    if(CPU_COUNT(allowed) == 0) {
+        return;
+    }
+    int target = thread % CPU_COUNT(allowed);
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if(CPU_ISSET(cpu, allowed) && target-- == 0) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+            return;
+        }
+    }
+}
+
+/* Give the calling thread back the CPUs it had when the pool started. */
+static void unpin_caller(thread_pool_t *pool) {
+    if(pool->pin) {
+        pthread_setaffinity_np(pthread_self(), sizeof(pool->allowed), &pool->allowed);
+    }
+}
+
+/* Thread's share of the current loop. */
+static void run_share(thread_pool_t *pool, int thread) {
+    long start = pool->start_index;
+    long length = pool->end_index - start;
+    if(pool->grain <= 0) {
+        long first = start + length * thread / pool->num_threads;
+        long last = start + length * (thread + 1) / pool->num_threads;
+        if(first < last) {
+            pool->fn(pool->arg, first, last, thread);
+        }
+        return;
+    }
+    while(1) {
+        long first = atomic_fetch_add_explicit(&pool->next, pool->grain, memory_order_relaxed);
+        if(first >= pool->end_index) {
+            return;
+        }
+        long last = first + pool->grain < pool->end_index ? first + pool->grain : pool->end_index;
+        pool->fn(pool->arg, first, last, thread);
+    }
+}
+
+static void *pool_worker(void *parameter) {
+    worker_t *worker = (worker_t *)parameter;
+    thread_pool_t *pool = worker->pool;
+    int thread = worker->thread;
+    free(worker);
+    if(pool->pin) {
+        pin_thread(&pool->allowed, thread);
+    }
+
+    long seen = 0;
+    while(1) {
+        pthread_mutex_lock(&pool->lock);
+        while(pool->generation == seen && !pool->shutdown) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if(pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_share(pool, thread);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* Start a pool of num_threads threads, counting the caller; with pin set,
+   bind each worker to its own CPU. */
+thread_pool_t *pool_create(int num_threads, int pin) {
+    thread_pool_t *pool = malloc(sizeof(thread_pool_t));
+    pool->num_threads = num_threads < 1 ? 1 : num_threads;
+    pool->threads = malloc(pool->num_threads * sizeof(pthread_t));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->shutdown = 0;
+    pool->pin = pin;
+    CPU_ZERO(&pool->allowed);
+    if(pin && sched_getaffinity(0, sizeof(pool->allowed), &pool->allowed) != 0) {
+        pool->pin = 0;
+    }
+
+    for(int t = 1; t < pool->num_threads; t++) {
+        worker_t *worker = malloc(sizeof(worker_t));
+        worker->pool = pool;
+        worker->thread = t;
+        if(pthread_create(&pool->threads[t], NULL, pool_worker, worker) != 0) {
+            fprintf(stderr, "Can't start thread %d of the pool\n", t);
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+void pool_destroy(thread_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for(int t = 1; t < pool->num_threads; t++) {
+        pthread_join(pool->threads[t], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool);
+}
+
+int pool_size(thread_pool_t *pool) {
+    return pool->num_threads;
+}
+
+/* Run fn over [start, end) on all the threads of the pool and wait for it
+   to finish; grain 0 gives each thread one block, the same every time,
+   grain > 0 deals out blocks of that many indexes. With pin set, the
+   caller is bound to thread 0's CPU for the loop and then let go. */
+void pool_parallel_for(thread_pool_t *pool, long start, long end, long grain, range_fn_t fn, void *arg) {
+    if(end <= start) {
+        return;
+    }
+    if(pool->pin) {
+        pin_thread(&pool->allowed, 0);
+    }
+    if(pool->num_threads == 1) {
+        fn(arg, start, end, 0);
+        unpin_caller(pool);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->start_index = start;
+    pool->end_index = end;
+    pool->grain = grain;
+    atomic_store_explicit(&pool->next, start, memory_order_relaxed);
+    pool->busy = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_share(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    unpin_caller(pool);
+}
+
+static void touch_pages(void *arg, long start, long end, int thread) {
+    memset((char *)arg + start, 0, end - start);
+}
+
+/* Zeroed, page-aligned memory for an array the pool will work on in
+   grain 0 loops: each thread writes the pages of its own block first, so
+   the kernel places them on its NUMA node. Free with free(). */
+void *pool_alloc(thread_pool_t *pool, size_t bytes) {
+    void *memory;
+    if(posix_memalign(&memory, sysconf(_SC_PAGESIZE), bytes > 0 ? bytes : 1) != 0) {
+        fprintf(stderr, "Can't allocate %zu bytes\n", bytes);
+        exit(1);
+    }
+    pool_parallel_for(pool, 0, (long)bytes, 0, touch_pages, memory);
+    return memory;
+}
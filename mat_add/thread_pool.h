@@ -0,0 +1,14 @@
+/* A pool of threads kept for many parallel loops; see thread_pool.c. */
+#include <stddef.h>
+
+typedef struct thread_pool thread_pool_t;
+
+/* Body of a parallel loop: handles indexes [start, end) on the given
+   thread of the pool (0 is the one that called pool_parallel_for()). */
+typedef void (*range_fn_t)(void *arg, long start, long end, int thread);
+
+extern thread_pool_t *pool_create(int num_threads, int pin);
+extern void pool_destroy(thread_pool_t *pool);
+extern int pool_size(thread_pool_t *pool);
+extern void pool_parallel_for(thread_pool_t *pool, long start, long end, long grain, range_fn_t fn, void *arg);
+extern void *pool_alloc(thread_pool_t *pool, size_t bytes);
@@ -1,5 +1,28 @@
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
 #define MAT_ELT(mat, cols, i, j) *(mat + (i * cols) + j)
 
+/* First bytes of a binary matrix file. */
+#define MATRIX_BINARY_MAGIC "MATB"
+
+/* A matrix read from disk; binary files are mapped, not copied. */
+typedef struct {
+    int rows;
+    int cols;
+    int *data;        /* rows * cols elements, row major */
+    void *map;        /* mmap'd file, or NULL if data was malloc'd */
+    size_t map_len;
+} matrix_file_t;
+
 extern void write_matrix(int *matrix, int rows, int cols, char *file_name);
+extern void write_matrix_binary(int *matrix, int rows, int cols, char *file_name);
 extern void generate_matrix(int rows, int cols, char *file_name);
 extern int *read_matrix(int *rows, int *cols, char *file_name);
+extern matrix_file_t *open_matrix(char *file_name);
+extern void close_matrix(matrix_file_t *m);
+extern int is_binary_name(char *file_name);
+extern void write_vectors(int fd, struct iovec *iov, int count, char *file_name);
+extern off_t write_matrix_header(int fd, int rows, int cols, char *file_name);
+extern int read_matrix_header(int fd, char *file_name, int *rows, int *cols, off_t *data_offset);
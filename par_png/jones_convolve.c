@@ -5,6 +5,8 @@
 #include <time.h>
 
 #include "lodepng.h"
+/* Build: gcc -std=gnu11 -O2 -pthread jones_convolve.c lodepng.c ../mat_add/thread_pool.c */
+#include "../mat_add/thread_pool.h"
 
 #define BYTES_PER_PIXEL 4
 #define RED_OFFSET 0
@@ -37,8 +39,6 @@ typedef struct
     image_t *input;
     image_t *output;
     kernel_t *kernel;
-    int thread;
-    int num_threads;
 } mystery_box_t;
 
 /**
@@ -116,7 +116,9 @@ int normalize_kernel(kernel_t kernel)
     return norm;
 }
 
-void *convolve(void *thing)
+/* Convolve rows [start, end) of the image; a pool_parallel_for() body.
+ */
+void convolve(void *thing, long start, long end, int thread)
 {
     //cast void * to my mystery_box_t object
     mystery_box_t *box = (mystery_box_t *)thing;
@@ -128,8 +130,8 @@ void *convolve(void *thing)
     int half_dim = KERNEL_DIM / 2;
     int kernel_norm = normalize_kernel(*kernel);
 
-    //Go through image by rows, jumping by the number of threads
-    for (int r = box->thread; r < rows; r += box->num_threads)
+    //Go through this thread's share of the rows
+    for (int r = start; r < end; r++)
     {
         for (int c = 0; c < columns; c++)
         {
@@ -179,8 +181,6 @@ void *convolve(void *thing)
             }
         }
     }
-
-    return (void *)NULL;
 }
 
 #define DEFAULT_KERNEL_NAME "identity"
@@ -245,6 +245,9 @@ void usage(char *prog_name, char *msge)
     fprintf(stderr, "  -k <kernel>          kernel from:\n");
     fprintf(stderr, "  -n <num threads>     # threads to use\n");
     fprintf(stderr, "  -s                   run threads in sequence (1, 2...p)\n");
+    fprintf(stderr, "  -g <rows>            hand out rows in blocks of this many\n");
+    fprintf(stderr, "                       as threads ask (default: one block each)\n");
+    fprintf(stderr, "  -p                   pin each thread to its own CPU\n");
 
     for (int i = 0; kernel_catalog[i].name; i++)
     {
@@ -258,15 +261,13 @@ void usage(char *prog_name, char *msge)
 /**
  * Method to initalize a new myster box struct
  */
-mystery_box_t *create_mystery_box(image_t *input, image_t *output, int current_thread, int num_threads, kernel_t *kernel)
+mystery_box_t *create_mystery_box(image_t *input, image_t *output, kernel_t *kernel)
 {
     //allocated memory is later freed
     mystery_box_t *new = malloc(sizeof(mystery_box_t));
     new->input = input;
     new->output = output;
     new->kernel = kernel;
-    new->thread = current_thread;
-    new->num_threads = num_threads;
     return new;
 }
 
@@ -291,9 +292,11 @@ int main(int argc, char **argv)
     char *output_file_name = NULL;
     int num_threads_used = 1;
     bool run_sequence = false;
+    long grain = 0;
+    bool pin = false;
 
     int ch;
-    while ((ch = getopt(argc, argv, "hi:k:o:n:s")) != -1)
+    while ((ch = getopt(argc, argv, "g:hi:k:o:n:ps")) != -1)
     {
         switch (ch)
         {
@@ -317,6 +320,12 @@ int main(int argc, char **argv)
         case 's':
             run_sequence = true;
             break;
+        case 'g':
+            grain = atol(optarg);
+            break;
+        case 'p':
+            pin = true;
+            break;
         case 'h':
         default:
             usage(prog_name, "");
@@ -342,45 +351,34 @@ int main(int argc, char **argv)
 
     image_t input;
     image_t output;
-    pthread_t threads[num_threads_used];
-    //mystery box for every thread being run
-    mystery_box_t *boxes[num_threads_used];
 
     //bring in input image and initialize output image
     load_and_decode(&input, input_file_name);
     init_image(&output, input.rows, input.columns);
+    //one mystery box, shared by the threads of the pool
+    mystery_box_t *box = create_mystery_box(&input, &output, &selected_entry->kernel);
 
     /**
      * This portion of the code runs image convolution for a number of
      * processors in sequence (convolve on 1, 2, ... n)
      * I created this functionality mostly for testing runtimes on
      * various processor sizes at once
+     * The threads of each pool are started before the timer.
      */
     if(run_sequence)
     {
         for(int c = 1; c <= num_threads_used; c++)
         {
-            for (int i = 0; i < c; i++)
-            {
-                //initalize all mystery boxes
-                boxes[i] = create_mystery_box(&input, &output, i, c, &selected_entry->kernel);
-            }
+            thread_pool_t *pool = pool_create(c, pin);
 
-            //start timer and run convolution for each thread
+            //start timer and run convolution on the pool
             double start_time = now();
-            for (int i = 0; i < c; i++)
-            {
-                pthread_create(&threads[i], NULL, convolve, boxes[i]);
-            }
-            for (int i = 0; i < c; i++)
-            {
-                pthread_join(threads[i], NULL);
-                free(boxes[i]);//free box memory
-            }
+            pool_parallel_for(pool, 0, input.rows, grain, convolve, box);
             if(c > 1)
                 printf("With %d cores, took %5.3f seconds\n", c, now()-start_time);
             else
                 printf("With 1 core, took %5.3f seconds\n", now()-start_time);
+            pool_destroy(pool);
         }
         encode_and_store(&output, output_file_name);
     }
@@ -390,26 +388,17 @@ int main(int argc, char **argv)
      */
     else
     {
-        for (int i = 0; i < num_threads_used; i++)
-        {
-            boxes[i] = create_mystery_box(&input, &output, i, num_threads_used, &selected_entry->kernel);
-        }
+        thread_pool_t *pool = pool_create(num_threads_used, pin);
         double start_time = now();
-        for (int i = 0; i < num_threads_used; i++)
-        {
-            pthread_create(&threads[i], NULL, convolve, boxes[i]);
-        }
-        for (int i = 0; i < num_threads_used; i++)
-        {
-            pthread_join(threads[i], NULL);
-            free(boxes[i]); //free box memory
-        }
+        pool_parallel_for(pool, 0, input.rows, grain, convolve, box);
         if(num_threads_used > 1)
                 printf("With %d cores, took %5.3f seconds\n", num_threads_used, now()-start_time);
             else
                 printf("With 1 core, took %5.3f seconds\n", now()-start_time);
+        pool_destroy(pool);
         encode_and_store(&output, output_file_name);
     }
+    free(box); //free box memory
 
     //free images
     free_image(&input);